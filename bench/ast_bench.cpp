@@ -0,0 +1,188 @@
+#include "bench_util.h"
+#include "file_buffer.h"
+#include "flat_ast.h"
+#include "lexer.h"
+#include "parser.h"
+#include "source_manager.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <streambuf>
+#include <string_view>
+
+namespace {
+
+constexpr std::string_view usage = "Usage: ast_bench <file>\n";
+
+/**
+ * @brief  Visits every node of a class tree, the way a later pass would.
+ * @return The number of nodes visited.
+ */
+std::size_t count_nodes(const cc::syntax_node &node)
+{
+    std::size_t count = 1;
+    for (const auto *child : node.children())
+    {
+        count += count_nodes(*child);
+    }
+    return count;
+}
+
+/**
+ * @brief  Visits every node of a flat tree below `index` by following child links.
+ * @return The number of nodes visited.
+ */
+std::size_t count_nodes(const cc::flat_ast &ast, cc::node_index index)
+{
+    std::size_t count = 1;
+    for (const auto child : ast.children(index))
+    {
+        count += count_nodes(ast, child);
+    }
+    return count;
+}
+
+/**
+ * @brief Asks for the body of every function, which parses the bodies that were skipped.
+ */
+void parse_deferred_bodies(const cc::syntax_node &node)
+{
+    if (node.type() == cc::syntax_type::function_declaration)
+    {
+        static_cast<const cc::function_declaration &>(node).definition();
+    }
+
+    for (const auto *child : node.children())
+    {
+        parse_deferred_bodies(*child);
+    }
+}
+
+/**
+ * @brief Discards what is written to it, so that only formatting the output is timed.
+ */
+class counting_buffer final : public std::streambuf
+{
+public:
+    std::size_t count() const
+    {
+        return count_;
+    }
+
+protected:
+    std::streamsize xsputn(const char *, std::streamsize n) override
+    {
+        count_ += static_cast<std::size_t>(n);
+        return n;
+    }
+
+    int_type overflow(int_type c) override
+    {
+        count_++;
+        return c;
+    }
+
+private:
+    std::size_t count_ = 0;
+};
+
+bool same_nodes(const cc::flat_ast &a, const cc::flat_ast &b)
+{
+    return std::equal(a.nodes().begin(), a.nodes().end(), b.nodes().begin(), b.nodes().end(),
+                      [](const cc::flat_node &x, const cc::flat_node &y) {
+                          return x.kind == y.kind && x.flags == y.flags && x.token == y.token &&
+                                 x.first_child == y.first_child && x.next_sibling == y.next_sibling;
+                      });
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << usage;
+        return EXIT_FAILURE;
+    }
+
+    const auto file = cc::bench::open_file(argv[1], usage);
+    if (!file)
+    {
+        return EXIT_FAILURE;
+    }
+    const auto file_id = cc::source_manager::instance().add_file(argv[1], file->contents());
+    auto lexer = cc::lexer(file_id);
+    std::optional<cc::token_buffer> lexed;
+    const auto lex = cc::bench::time_ms([&] { lexed = lexer.lex_buffer(); });
+    const auto &tokens = *lexed;
+
+    auto parser = cc::parser(tokens);
+    std::unique_ptr<cc::syntax_node> tree;
+    const auto tree_parse = cc::bench::time_ms([&] { tree = parser.parse_contents(); });
+
+    if (!parser.diagnostics().empty())
+    {
+        for (const auto &diagnostic : parser.diagnostics())
+        {
+            std::cerr << diagnostic.to_string() << '\n';
+        }
+        return EXIT_FAILURE;
+    }
+
+    std::optional<cc::flat_ast> flat;
+    const auto flat_parse = cc::bench::time_ms([&] { flat = cc::flat_parser(tokens).parse_contents(); });
+
+    // Both parsers must produce the same tree, whichever way it is converted
+    if (cc::to_syntax_tree(*flat)->tree_representation() != tree->tree_representation())
+    {
+        std::cerr << "The flat tree differs from the class tree\n";
+        return EXIT_FAILURE;
+    }
+    if (!same_nodes(cc::to_flat_ast(*tree), *flat))
+    {
+        std::cerr << "The converted class tree differs from the flat tree\n";
+        return EXIT_FAILURE;
+    }
+
+    // Parsing every skipped body must give the same tree as parsing them in place
+    auto lazy_parser = cc::parser(tokens);
+    std::unique_ptr<cc::syntax_node> lazy;
+    const auto declarations_parse = cc::bench::time_ms([&] { lazy = lazy_parser.parse_declarations(); });
+    const auto deferred_parse = cc::bench::time_ms([&] { parse_deferred_bodies(*lazy); });
+    if (!lazy_parser.diagnostics().empty() || lazy->tree_representation() != tree->tree_representation())
+    {
+        std::cerr << "Parsing skipped bodies gives a different tree\n";
+        return EXIT_FAILURE;
+    }
+
+    std::size_t tree_count = 0;
+    std::size_t flat_count = 0;
+    const auto tree_walk = cc::bench::time_ms([&] { tree_count = count_nodes(*tree); });
+    const auto flat_walk = cc::bench::time_ms([&] { flat_count = count_nodes(*flat, flat->root()); });
+    if (tree_count != flat_count || flat_count != flat->size())
+    {
+        std::cerr << "Traversals visited different numbers of nodes\n";
+        return EXIT_FAILURE;
+    }
+
+    counting_buffer dumped;
+    auto dump_stream = std::ostream(&dumped);
+    const auto tree_dump = cc::bench::time_ms([&] { tree->print_tree(dump_stream); });
+
+    cc::bench::print_row("nodes", static_cast<double>(flat->size()), "");
+    cc::bench::print_row("flat tree size", static_cast<double>(flat->nodes().size_bytes()) / (1024.0 * 1024.0), "MiB");
+    cc::bench::print_row("lex", lex, "ms");
+    cc::bench::print_row("class tree parse", tree_parse, "ms");
+    cc::bench::print_row("declarations parse", declarations_parse, "ms");
+    cc::bench::print_row("deferred bodies parse", deferred_parse, "ms");
+    cc::bench::print_row("flat tree parse", flat_parse, "ms");
+    cc::bench::print_row("class tree walk", tree_walk, "ms");
+    cc::bench::print_row("flat tree walk", flat_walk, "ms");
+    cc::bench::print_row("class tree dump", tree_dump, "ms");
+    cc::bench::print_row("dump size", static_cast<double>(dumped.count()) / (1024.0 * 1024.0), "MiB");
+
+    return EXIT_SUCCESS;
+}
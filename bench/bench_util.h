@@ -0,0 +1,65 @@
+#ifndef C_COMPILER_BENCH_UTIL_H
+#define C_COMPILER_BENCH_UTIL_H
+
+#include "file_buffer.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace cc::bench {
+
+/**
+ * @brief The width of the label column of the tables that benches print.
+ */
+inline constexpr int label_column_width = 24;
+
+/**
+ * @brief  Runs `f` once.
+ * @return The time it took, in milliseconds.
+ */
+template<typename F>
+double time_ms(F &&f)
+{
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Prints one row of a bench's result table: a label, and a value with its unit.
+ */
+inline void print_row(std::string_view label, double value, std::string_view unit)
+{
+    std::cout << std::left << std::setw(label_column_width) << label << std::fixed << std::setprecision(2) << value
+              << ' ' << unit << '\n';
+}
+
+/**
+ * @brief  Opens a file named on the command line. If it cannot be opened or read, prints why,
+ *         followed by the usage of the bench.
+ * @return The file, or nothing if it cannot be read.
+ */
+inline std::optional<cc::file_buffer> open_file(const std::string &file_name, std::string_view usage)
+{
+    std::optional<cc::file_buffer> file;
+
+    try
+    {
+        file.emplace(file_name);
+    }
+    catch (const std::system_error &e)
+    {
+        std::cerr << e.what() << '\n' << usage;
+    }
+
+    return file;
+}
+
+} // namespace cc::bench
+
+#endif
@@ -0,0 +1,432 @@
+#include "bench_util.h"
+#include "file_buffer.h"
+#include "lexer.h"
+#include "parallel_lexer.h"
+#include "source_manager.h"
+#include "token.h"
+#include "token_buffer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <new>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr std::string_view usage = "Usage: lexer_bench <file> [iterations]\n"
+                                   "       lexer_bench --corpus <kind> <megabytes> [iterations]\n"
+                                   "\n"
+                                   "Corpus kinds: identifiers, numbers, strings, whitespace, comments, all\n";
+
+constexpr int default_iterations = 5;
+
+// Counts every call to the global operator new, which this file replaces below
+std::atomic<std::size_t> allocation_count = 0;
+
+struct engine_run
+{
+    const char *name;
+    cc::lexer_engine engine;
+};
+
+constexpr engine_run engines[] = {
+    {"hand_written", cc::lexer_engine::hand_written},
+    {"table_driven", cc::lexer_engine::table_driven},
+};
+
+// Words that generated corpora are made of
+constexpr const char *corpus_words[] = {
+    "returns", "the", "number", "of", "bytes", "in", "buffer", "must", "not", "be", "null",
+    "pointer", "to", "first", "element", "caller", "owns", "result", "see", "also", "length",
+};
+
+constexpr const char *corpus_keywords[] = {
+    "int", "char", "const", "static", "double", "return", "if", "while", "struct", "void",
+};
+
+/**
+ * @brief Picks pseudo-random values for corpus generators. The output of std::mt19937 is fully
+ *        specified, unlike that of the standard distributions, so a corpus is the same on every
+ *        platform and only depends on its size.
+ */
+class corpus_random
+{
+public:
+    std::size_t pick(std::size_t count)
+    {
+        return random_() % count;
+    }
+
+    template<std::size_t N>
+    const char *pick(const char *const (&words)[N])
+    {
+        return words[pick(N)];
+    }
+
+private:
+    std::mt19937 random_{42};
+};
+
+/**
+ * @brief  Generates a header-like corpus in which most of the bytes are comments: a documentation
+ *         block before every declaration and a trailing line comment after most of them.
+ */
+std::string generate_comment_corpus(std::size_t size)
+{
+    auto random = corpus_random();
+
+    std::string corpus;
+    corpus.reserve(size + 1024);
+
+    for (std::size_t declaration = 0; corpus.size() < size; declaration++)
+    {
+        corpus += "/**\n";
+        for (std::size_t line = 0, lines = 2 + random.pick(4); line < lines; line++)
+        {
+            corpus += " *";
+            for (std::size_t word = 0, length = 4 + random.pick(8); word < length; word++)
+            {
+                corpus += ' ';
+                corpus += random.pick(corpus_words);
+            }
+            corpus += '\n';
+        }
+        corpus += " */\n";
+
+        corpus += "int declaration_" + std::to_string(declaration) + " = " + std::to_string(random.pick(100000)) + ";";
+        if (random.pick(4) != 0)
+        {
+            corpus += " // ";
+            corpus += random.pick(corpus_words);
+            corpus += ' ';
+            corpus += random.pick(corpus_words);
+        }
+        corpus += "\n\n";
+    }
+
+    return corpus;
+}
+
+/**
+ * @brief  Generates statements that are almost entirely identifiers and keywords, joined by single
+ *         punctuators.
+ */
+std::string generate_identifier_corpus(std::size_t size)
+{
+    constexpr const char *operators[] = {" = ", " + ", " * ", " && ", " < ", ", "};
+
+    auto random = corpus_random();
+
+    std::string corpus;
+    corpus.reserve(size + 1024);
+
+    while (corpus.size() < size)
+    {
+        corpus += "    ";
+        corpus += random.pick(corpus_keywords);
+        for (std::size_t word = 0, length = 2 + random.pick(6); word < length; word++)
+        {
+            corpus += ' ';
+            corpus += random.pick(corpus_words);
+            if (random.pick(2) != 0)
+            {
+                corpus += '_';
+                corpus += random.pick(corpus_words);
+            }
+            corpus += random.pick(operators);
+            corpus += random.pick(corpus_words);
+        }
+        corpus += ";\n";
+    }
+
+    return corpus;
+}
+
+/**
+ * @brief  Generates initializer lists of integer, octal, double and float literals, with and
+ *         without exponents.
+ */
+std::string generate_number_corpus(std::size_t size)
+{
+    auto random = corpus_random();
+
+    std::string corpus;
+    corpus.reserve(size + 1024);
+
+    while (corpus.size() < size)
+    {
+        corpus += "{ ";
+        for (std::size_t number = 0; number < 16; number++)
+        {
+            const auto integer = std::to_string(random.pick(1000000));
+            switch (random.pick(5))
+            {
+            case 0:
+            {
+                corpus += integer;
+                break;
+            }
+            case 1:
+            {
+                corpus += '0';
+                corpus += std::to_string(random.pick(010000));
+                break;
+            }
+            case 2:
+            {
+                corpus += integer + "." + std::to_string(random.pick(1000));
+                break;
+            }
+            case 3:
+            {
+                corpus += integer + "." + std::to_string(random.pick(100)) + "e" + (random.pick(2) != 0 ? "-" : "+") +
+                          std::to_string(random.pick(300));
+                break;
+            }
+            default:
+            {
+                corpus += std::to_string(random.pick(1000)) + "." + std::to_string(random.pick(1000)) + "f";
+                break;
+            }
+            }
+            corpus += ", ";
+        }
+        corpus += "}\n";
+    }
+
+    return corpus;
+}
+
+/**
+ * @brief  Generates string literals of a few words each. Some contain escape sequences, and a few
+ *         are continued onto the next line, which makes the lexer decode them.
+ */
+std::string generate_string_corpus(std::size_t size)
+{
+    constexpr const char *escapes[] = {"\\n", "\\t", "\\\"", "\\\\"};
+
+    auto random = corpus_random();
+
+    std::string corpus;
+    corpus.reserve(size + 1024);
+
+    while (corpus.size() < size)
+    {
+        corpus += "    \"";
+        for (std::size_t word = 0, length = 1 + random.pick(12); word < length; word++)
+        {
+            if (word != 0)
+            {
+                corpus += ' ';
+            }
+            corpus += random.pick(corpus_words);
+            if (random.pick(8) == 0)
+            {
+                corpus += random.pick(escapes);
+            }
+            if (random.pick(64) == 0)
+            {
+                corpus += "\\\n";
+            }
+        }
+        corpus += "\",\n";
+    }
+
+    return corpus;
+}
+
+/**
+ * @brief  Generates short statements separated by long runs of indentation, blank lines and
+ *         trailing whitespace.
+ */
+std::string generate_whitespace_corpus(std::size_t size)
+{
+    constexpr const char *blanks[] = {" ", "\t", "\n", "\r\n"};
+
+    auto random = corpus_random();
+
+    std::string corpus;
+    corpus.reserve(size + 1024);
+
+    while (corpus.size() < size)
+    {
+        corpus.append(4 * random.pick(16), ' ');
+        corpus += random.pick(corpus_words);
+        corpus += ';';
+        for (std::size_t blank = 0, length = random.pick(64); blank < length; blank++)
+        {
+            corpus += random.pick(blanks);
+        }
+        corpus += '\n';
+    }
+
+    return corpus;
+}
+
+struct corpus_kind
+{
+    const char *name;
+    std::string (*generate)(std::size_t size);
+};
+
+constexpr corpus_kind corpus_kinds[] = {
+    {"identifiers", generate_identifier_corpus},
+    {"numbers", generate_number_corpus},
+    {"strings", generate_string_corpus},
+    {"whitespace", generate_whitespace_corpus},
+    {"comments", generate_comment_corpus},
+};
+
+struct measurement
+{
+    std::chrono::duration<double> best;
+    std::size_t token_count;
+    std::size_t allocation_count;
+};
+
+/**
+ * @brief  Runs `lex` `iterations` times and keeps the fastest run. `lex` returns the number of
+ *         tokens it produced.
+ */
+template<typename Function>
+measurement measure(int iterations, Function lex)
+{
+    auto result = measurement{std::chrono::duration<double>::max(), 0, 0};
+
+    for (int i = 0; i < iterations; i++)
+    {
+        const auto allocations = allocation_count.load(std::memory_order_relaxed);
+        const auto start = std::chrono::steady_clock::now();
+        result.token_count = lex();
+        result.best = std::min<std::chrono::duration<double>>(result.best, std::chrono::steady_clock::now() - start);
+        result.allocation_count = allocation_count.load(std::memory_order_relaxed) - allocations;
+    }
+
+    return result;
+}
+
+void print_header()
+{
+    std::cout << "corpus,lexer,bytes,tokens,seconds,mb_per_s,mtokens_per_s,allocations_per_token\n";
+}
+
+void print_result(std::string_view corpus, std::string_view lexer, std::size_t source_size, const measurement &result)
+{
+    const double seconds = result.best.count();
+    const auto tokens = static_cast<double>(result.token_count);
+
+    std::cout << corpus << ',' << lexer << ',' << source_size << ',' << result.token_count << ','
+              << std::fixed << std::setprecision(6) << seconds << ','
+              << std::setprecision(1) << static_cast<double>(source_size) / seconds / 1e6 << ','
+              << std::setprecision(2) << tokens / seconds / 1e6 << ','
+              << std::setprecision(4) << static_cast<double>(result.allocation_count) / tokens << '\n';
+}
+
+/**
+ * @brief  Times every lexer on one source.
+ */
+void run(std::string_view corpus, std::string_view source, int iterations)
+{
+    const auto source_file = cc::source_manager::instance().add_file(std::string(corpus), source);
+
+    for (const auto &[name, engine] : engines)
+    {
+        const auto result = measure(iterations, [&] {
+            auto lexer = cc::lexer(source_file, engine);
+            return lexer.lex_contents().size();
+        });
+        print_result(corpus, name, source.size(), result);
+    }
+
+    const auto thread_count = std::max(std::thread::hardware_concurrency(), 1U);
+    const auto result = measure(iterations, [&] {
+        auto lexer = cc::parallel_lexer(source_file, thread_count);
+        return lexer.lex_buffer().size();
+    });
+    print_result(corpus, "parallel_x" + std::to_string(thread_count), source.size(), result);
+}
+
+} // namespace
+
+void *operator new(std::size_t size)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+
+    if (void *memory = std::malloc(size == 0 ? 1 : size))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+int main(int argc, char **argv)
+{
+    const bool is_generated = argc > 1 && std::string_view(argv[1]) == "--corpus";
+    const int first_option = is_generated ? 4 : 2;
+
+    if (argc < first_option)
+    {
+        std::cerr << usage;
+        return EXIT_FAILURE;
+    }
+
+    const int iterations = argc > first_option ? std::atoi(argv[first_option]) : default_iterations;
+
+    if (!is_generated)
+    {
+        const auto file = cc::bench::open_file(argv[1], usage);
+        if (!file)
+        {
+            return EXIT_FAILURE;
+        }
+
+        print_header();
+        run(argv[1], file->contents(), iterations);
+        return EXIT_SUCCESS;
+    }
+
+    const auto kind = std::string_view(argv[2]);
+    const auto size = static_cast<std::size_t>(std::atof(argv[3]) * 1e6);
+
+    const auto is_selected = [&](const corpus_kind &corpus) { return kind == "all" || kind == corpus.name; };
+    if (std::none_of(std::begin(corpus_kinds), std::end(corpus_kinds), is_selected))
+    {
+        std::cerr << "Unknown corpus kind: " << kind << '\n';
+        return EXIT_FAILURE;
+    }
+
+    // Sources have to outlive the source manager's view of them
+    std::deque<std::string> corpora;
+
+    print_header();
+    for (const auto &corpus : corpus_kinds)
+    {
+        if (is_selected(corpus))
+        {
+            run(corpus.name, corpora.emplace_back(corpus.generate(size)), iterations);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
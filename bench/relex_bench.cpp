@@ -0,0 +1,123 @@
+#include "bench_util.h"
+#include "file_buffer.h"
+#include "incremental_lexer.h"
+#include "source_manager.h"
+#include "token.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+constexpr std::string_view usage = "Usage: relex_bench <file> [edits]\n";
+
+constexpr std::size_t default_edit_count = 1000;
+
+// Text that edits insert. Besides ordinary code, it contains everything that can make a token run
+// on past the edit: comment delimiters, quotes, line continuations and partial numbers.
+constexpr std::string_view insertions[] = {
+    "", "a", "x1", "_tmp", "int ", "return ", " ", "\t", "\n", "\r\n", "\\\n", "\\", "/", "*", "/*", "*/",
+    "//", "\"", "\"abc\"", "'", "0", "1.5", "e+", "3f", "0x1F", "(", ")", "{", "}", ";", "+=", "...",
+    "/* comment */", "// comment\n", "\"unterminated",
+};
+
+/**
+ * @brief  Picks a random edit to `text`. Most edits are small, like typing or deleting a few
+ *         characters; some remove a larger stretch.
+ * @return The edit and the text it inserts.
+ */
+std::pair<cc::text_edit, std::string_view> random_edit(std::string_view text, std::mt19937 &random)
+{
+    const auto offset = std::uniform_int_distribution<std::size_t>(0, text.size())(random);
+    const auto max_removed = std::bernoulli_distribution(0.05)(random) ? std::size_t(256) : std::size_t(4);
+    const auto removed = std::min(std::uniform_int_distribution<std::size_t>(0, max_removed)(random), text.size() - offset);
+    const auto inserted = insertions[std::uniform_int_distribution<std::size_t>(0, std::size(insertions) - 1)(random)];
+
+    const auto edit = cc::text_edit{
+        .offset          = static_cast<std::uint32_t>(offset),
+        .removed_length  = static_cast<std::uint32_t>(removed),
+        .inserted_length = static_cast<std::uint32_t>(inserted.size()),
+    };
+    return {edit, inserted};
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << usage;
+        return EXIT_FAILURE;
+    }
+
+    const auto file = cc::bench::open_file(argv[1], usage);
+    if (!file)
+    {
+        return EXIT_FAILURE;
+    }
+    const auto edit_count = argc > 2 ? static_cast<std::size_t>(std::atol(argv[2])) : default_edit_count;
+
+    // Every edit produces a new buffer. The previous one has to stay alive until the lexer has moved
+    // over to the new one. A deque never relocates its elements, so views into them stay valid.
+    std::deque<std::string> buffers;
+    buffers.emplace_back(file->contents());
+
+    const auto full_start = std::chrono::steady_clock::now();
+    auto incremental = cc::incremental_lexer(cc::source_manager::instance().add_file(argv[1], buffers.back()));
+    const std::chrono::duration<double> full_time = std::chrono::steady_clock::now() - full_start;
+
+    std::mt19937 random(42);
+    std::vector<double> latencies;
+    latencies.reserve(edit_count);
+    std::size_t relexed_count = 0;
+
+    for (std::size_t i = 0; i < edit_count; i++)
+    {
+        const auto &previous = buffers.back();
+        const auto [edit, inserted] = random_edit(previous, random);
+
+        auto &current = buffers.emplace_back();
+        current.reserve(previous.size() - edit.removed_length + inserted.size());
+        current.append(previous, 0, edit.offset);
+        current.append(inserted);
+        current.append(previous, edit.offset + edit.removed_length);
+
+        const auto start = std::chrono::steady_clock::now();
+        const auto range = incremental.apply_edit(current, edit);
+        latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        relexed_count += range.inserted_count;
+
+        buffers.pop_front();
+    }
+
+    if (latencies.empty())
+    {
+        return EXIT_SUCCESS;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    const auto percentile = [&](double fraction) {
+        return latencies[static_cast<std::size_t>(fraction * static_cast<double>(latencies.size() - 1))];
+    };
+
+    const auto edits = static_cast<double>(latencies.size());
+    cc::bench::print_row("tokens", static_cast<double>(incremental.tokens().size()), "");
+    cc::bench::print_row("full lex", std::chrono::duration<double, std::micro>(full_time).count(), "us");
+    cc::bench::print_row("edit mean", std::accumulate(latencies.begin(), latencies.end(), 0.0) / edits, "us");
+    cc::bench::print_row("edit median", percentile(0.5), "us");
+    cc::bench::print_row("edit p99", percentile(0.99), "us");
+    cc::bench::print_row("edit max", latencies.back(), "us");
+    cc::bench::print_row("relexed tokens/edit", static_cast<double>(relexed_count) / edits, "");
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,221 @@
+#include "bench_util.h"
+#include "file_buffer.h"
+#include "flat_ast.h"
+#include "lexer.h"
+#include "parser.h"
+#include "serialized_ast.h"
+#include "source_manager.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+constexpr std::string_view usage = "Usage: serialization_bench <file> [repetitions] [output]\n";
+
+constexpr std::size_t default_repetitions = 10;
+
+constexpr double bytes_per_mib = 1024.0 * 1024.0;
+
+/**
+ * @brief What a walk over a tree reads from every node, so that walks over a flat tree and over a
+ *        serialized one can be checked against each other.
+ */
+struct walk_result
+{
+    std::size_t nodes = 0;
+    std::size_t text_size = 0;
+    std::size_t line_sum = 0;
+
+    bool operator==(const walk_result &) const = default;
+};
+
+void walk(const cc::flat_ast &ast, cc::node_index index, walk_result &result)
+{
+    const auto token = ast.token(index);
+    result.nodes++;
+    result.text_size += token.text().size();
+    result.line_sum += token.position().line;
+
+    for (const auto child : ast.children(index))
+    {
+        walk(ast, child, result);
+    }
+}
+
+void walk(const cc::serialized_ast &ast, cc::node_index index, walk_result &result)
+{
+    const auto &token = ast.token(index);
+    result.nodes++;
+    result.text_size += ast.text(token).size();
+    result.line_sum += token.line;
+
+    for (const auto child : ast.children(index))
+    {
+        walk(ast, child, result);
+    }
+}
+
+bool same_token(cc::token_ref a, cc::token_ref b)
+{
+    return a.type() == b.type() && a.text() == b.text() && a.value() == b.value() && a.position() == b.position();
+}
+
+/**
+ * @brief  Whether two flat trees have the same nodes, whose tokens have the same text and position,
+ *         even though the tokens come from different buffers.
+ */
+bool same_tree(const cc::flat_ast &a, const cc::flat_ast &b)
+{
+    if (a.size() != b.size())
+    {
+        return false;
+    }
+
+    for (cc::node_index i = 0; i < a.size(); i++)
+    {
+        const auto &x = a[i];
+        const auto &y = b[i];
+        if (x.kind != y.kind || x.flags != y.flags || x.first_child != y.first_child || x.next_sibling != y.next_sibling ||
+            !same_token(a.token(i), b.token(i)))
+        {
+            return false;
+        }
+
+        const auto is_declaration = x.kind == cc::syntax_type::variable_declaration ||
+                                    x.kind == cc::syntax_type::function_declaration;
+        if (is_declaration && !same_token(a.tokens()[x.token + 1], b.tokens()[y.token + 1]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << usage;
+        return EXIT_FAILURE;
+    }
+
+    const auto repetitions = argc > 2 ? static_cast<std::size_t>(std::atol(argv[2])) : default_repetitions;
+    if (repetitions == 0)
+    {
+        std::cerr << usage;
+        return EXIT_FAILURE;
+    }
+
+    const auto file = cc::bench::open_file(argv[1], usage);
+    if (!file)
+    {
+        return EXIT_FAILURE;
+    }
+    const auto file_id = cc::source_manager::instance().add_file(argv[1], file->contents());
+    auto lexer = cc::lexer(file_id);
+    const auto tokens = lexer.lex_buffer();
+
+    // Trees with syntax errors are serialized as well, error nodes and all
+    auto parser = cc::flat_parser(tokens);
+    const auto flat = parser.parse_contents();
+
+    std::vector<std::byte> bytes;
+    const auto write_time = cc::bench::time_ms([&] {
+        for (std::size_t i = 0; i < repetitions; i++)
+        {
+            bytes = cc::serialize(flat);
+        }
+    });
+
+    std::optional<cc::serialized_ast> serialized;
+    const auto open_time = cc::bench::time_ms([&] {
+        for (std::size_t i = 0; i < repetitions; i++)
+        {
+            serialized.emplace(bytes);
+        }
+    });
+
+    walk_result flat_walk;
+    walk_result serialized_walk;
+    const auto flat_walk_time = cc::bench::time_ms([&] {
+        for (std::size_t i = 0; i < repetitions; i++)
+        {
+            flat_walk = {};
+            walk(flat, flat.root(), flat_walk);
+        }
+    });
+    const auto serialized_walk_time = cc::bench::time_ms([&] {
+        for (std::size_t i = 0; i < repetitions; i++)
+        {
+            serialized_walk = {};
+            walk(*serialized, serialized->root(), serialized_walk);
+        }
+    });
+
+    if (flat_walk != serialized_walk)
+    {
+        std::cerr << "The walks over the flat and the serialized tree disagree\n";
+        return EXIT_FAILURE;
+    }
+
+    std::string source;
+    std::optional<cc::flat_ast> read_back;
+    const auto read_back_time = cc::bench::time_ms([&] { read_back = cc::to_flat_ast(*serialized, source); });
+
+    if (!same_tree(flat, *read_back) ||
+        cc::to_syntax_tree(*read_back)->tree_representation() != cc::to_syntax_tree(flat)->tree_representation())
+    {
+        std::cerr << "The tree read back differs from the tree that was serialized\n";
+        return EXIT_FAILURE;
+    }
+
+    // Walk the tree straight from a mapped file, the way a consumer of the front end would
+    if (argc > 3)
+    {
+        std::ofstream(argv[3], std::ios::binary).write(reinterpret_cast<const char *>(bytes.data()),
+                                                       static_cast<std::streamsize>(bytes.size()));
+
+        const auto mapped = cc::bench::open_file(argv[3], usage);
+        if (!mapped)
+        {
+            return EXIT_FAILURE;
+        }
+
+        walk_result mapped_walk;
+        walk(cc::serialized_ast(std::as_bytes(std::span(mapped->contents()))), flat.root(), mapped_walk);
+
+        if (mapped_walk != flat_walk)
+        {
+            std::cerr << "The walk over the mapped file disagrees\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    const auto size = static_cast<double>(bytes.size());
+    const auto total_size = size * static_cast<double>(repetitions);
+
+    cc::bench::print_row("nodes", static_cast<double>(flat.size()), "");
+    cc::bench::print_row("tokens stored", static_cast<double>(serialized->tokens().size()), "");
+    cc::bench::print_row("diagnostics", static_cast<double>(parser.diagnostics().size()), "");
+    cc::bench::print_row("serialized size", size / bytes_per_mib, "MiB");
+    cc::bench::print_row("bytes per node", size / static_cast<double>(flat.size()), "B");
+    cc::bench::print_row("write", write_time / static_cast<double>(repetitions), "ms");
+    cc::bench::print_row("write throughput", total_size / bytes_per_mib / (write_time / 1000.0), "MiB/s");
+    cc::bench::print_row("open", open_time / static_cast<double>(repetitions), "ms");
+    cc::bench::print_row("open throughput", total_size / bytes_per_mib / (open_time / 1000.0), "MiB/s");
+    cc::bench::print_row("flat tree walk", flat_walk_time / static_cast<double>(repetitions), "ms");
+    cc::bench::print_row("serialized walk", serialized_walk_time / static_cast<double>(repetitions), "ms");
+    cc::bench::print_row("read back", read_back_time, "ms");
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,335 @@
+#include "bench_util.h"
+#include "identifier_table.h"
+#include "lexer.h"
+#include "parser.h"
+#include "source_manager.h"
+#include "symbol_table.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t default_depth = 64;
+constexpr std::size_t default_locals = 16;
+constexpr std::size_t function_count = 64;
+constexpr std::size_t global_count = 1024;
+constexpr std::size_t references_per_local = 3;
+constexpr std::size_t repetitions = 10;
+
+using flat_symbol_table = cc::parser::symbol_table;
+
+/**
+ * @brief The symbol table as the parser used to have it: a hash map per scope, chained to the
+ *        enclosing scope, so lookups hash the name again at every level they pass.
+ */
+class chained_symbol_table
+{
+public:
+    explicit chained_symbol_table(const chained_symbol_table *enclosing = nullptr)
+        : enclosing_(enclosing)
+    {
+    }
+
+    bool is_declared(cc::identifier_id identifier) const
+    {
+        return symbols_.find(identifier) != symbols_.end() || (enclosing_ && enclosing_->is_declared(identifier));
+    }
+
+    bool is_declared_in_scope(cc::identifier_id identifier) const
+    {
+        return symbols_.find(identifier) != symbols_.end();
+    }
+
+    bool is_defined(cc::identifier_id identifier) const
+    {
+        if (const auto it = symbols_.find(identifier); it != symbols_.end() && it->second)
+        {
+            return true;
+        }
+
+        return enclosing_ && enclosing_->is_defined(identifier);
+    }
+
+    void declare(cc::identifier_id identifier)
+    {
+        symbols_.insert({identifier, false});
+    }
+
+    void define(cc::identifier_id identifier)
+    {
+        symbols_[identifier] = true;
+    }
+
+private:
+    std::unordered_map<cc::identifier_id, bool> symbols_;
+    const chained_symbol_table *enclosing_;
+};
+
+/**
+ * @brief What the parser asks of its symbol table, in the order it asks.
+ */
+struct operation
+{
+    enum class kind
+    {
+        enter_scope,
+        leave_scope,
+        declare,
+        define,
+        is_declared,
+        is_declared_in_scope,
+        is_defined,
+    };
+
+    kind what;
+    cc::identifier_id identifier;
+};
+
+/**
+ * @brief A program of functions whose bodies are deeply nested blocks with many locals, as source
+ *        text and as the operations that parsing it performs on the symbol table. Half of the
+ *        locals in each block shadow a local of every enclosing block.
+ */
+struct workload
+{
+    std::string source;
+    std::vector<operation> operations;
+
+    void add(operation::kind what, std::string_view name = {})
+    {
+        const auto identifier = name.empty() ? cc::invalid_identifier : cc::identifier_table::instance().intern(name);
+        operations.push_back({what, identifier});
+    }
+};
+
+workload generate_workload(std::size_t depth, std::size_t locals)
+{
+    std::mt19937 random(42);
+    const auto pick = [&](std::size_t count) { return std::uniform_int_distribution<std::size_t>(0, count - 1)(random); };
+
+    workload result;
+
+    for (std::size_t i = 0; i < global_count; i++)
+    {
+        const auto name = "g" + std::to_string(i);
+        result.source += "int " + name + " = 0;\n";
+        result.add(operation::kind::is_declared_in_scope, name);
+        result.add(operation::kind::declare, name);
+        result.add(operation::kind::define, name);
+    }
+
+    for (std::size_t f = 0; f < function_count; f++)
+    {
+        const auto function_name = "f" + std::to_string(f);
+        result.source += "int " + function_name + "()\n";
+        result.add(operation::kind::is_declared, function_name);
+        result.add(operation::kind::declare, function_name);
+        result.add(operation::kind::is_defined, function_name);
+
+        for (std::size_t d = 0; d < depth; d++)
+        {
+            result.source += "{\n";
+            result.add(operation::kind::enter_scope);
+
+            for (std::size_t k = 0; k < locals; k++)
+            {
+                const auto name = k % 2 == 0 ? "s" + std::to_string(k)
+                                             : "d" + std::to_string(d) + "_" + std::to_string(k);
+                result.add(operation::kind::is_declared_in_scope, name);
+                result.add(operation::kind::declare, name);
+
+                result.source += "int " + name + " =";
+                for (std::size_t r = 0; r < references_per_local; r++)
+                {
+                    // A global, a shadowed local or a local of some enclosing block
+                    std::string reference;
+                    const auto choice = d == 0 ? 0 : pick(3);
+                    if (choice == 0)
+                    {
+                        reference = "g" + std::to_string(pick(global_count));
+                    }
+                    else if (choice == 1)
+                    {
+                        reference = "s" + std::to_string(pick((locals + 1) / 2) * 2);
+                    }
+                    else
+                    {
+                        reference = "d" + std::to_string(pick(d)) + "_" + std::to_string(pick(locals / 2) * 2 + 1);
+                    }
+
+                    result.source += (r == 0 ? " " : " + ") + reference;
+                    result.add(operation::kind::is_declared, reference);
+                }
+                result.source += ";\n";
+
+                result.add(operation::kind::define, name);
+            }
+        }
+
+        for (std::size_t d = depth; d-- > 0;)
+        {
+            if (d == 0)
+            {
+                result.source += "return g0;\n";
+                result.add(operation::kind::is_declared, "g0");
+            }
+
+            result.source += "}\n";
+            result.add(operation::kind::leave_scope);
+        }
+
+        result.add(operation::kind::define, function_name);
+    }
+
+    return result;
+}
+
+/**
+ * @return The answer to every query, in order.
+ */
+std::vector<bool> replay(const std::vector<operation> &operations, flat_symbol_table &table)
+{
+    std::vector<bool> answers;
+    std::uint32_t position = 0;
+
+    for (const auto &op : operations)
+    {
+        position++;
+
+        switch (op.what)
+        {
+        case operation::kind::enter_scope:
+            table.enter_scope();
+            break;
+        case operation::kind::leave_scope:
+            table.leave_scope();
+            break;
+        case operation::kind::declare:
+            table.declare(op.identifier, position);
+            break;
+        case operation::kind::define:
+            table.define(op.identifier, position);
+            break;
+        case operation::kind::is_declared:
+            answers.push_back(table.is_declared(op.identifier));
+            break;
+        case operation::kind::is_declared_in_scope:
+            answers.push_back(table.is_declared_in_scope(op.identifier));
+            break;
+        case operation::kind::is_defined:
+            answers.push_back(table.is_defined(op.identifier));
+            break;
+        }
+    }
+
+    return answers;
+}
+
+std::vector<bool> replay(const std::vector<operation> &operations, std::deque<chained_symbol_table> &scopes)
+{
+    std::vector<bool> answers;
+
+    for (const auto &op : operations)
+    {
+        switch (op.what)
+        {
+        case operation::kind::enter_scope:
+            scopes.emplace_back(&scopes.back());
+            break;
+        case operation::kind::leave_scope:
+            scopes.pop_back();
+            break;
+        case operation::kind::declare:
+            scopes.back().declare(op.identifier);
+            break;
+        case operation::kind::define:
+            scopes.back().define(op.identifier);
+            break;
+        case operation::kind::is_declared:
+            answers.push_back(scopes.back().is_declared(op.identifier));
+            break;
+        case operation::kind::is_declared_in_scope:
+            answers.push_back(scopes.back().is_declared_in_scope(op.identifier));
+            break;
+        case operation::kind::is_defined:
+            answers.push_back(scopes.back().is_defined(op.identifier));
+            break;
+        }
+    }
+
+    return answers;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const auto depth = argc > 1 ? static_cast<std::size_t>(std::atol(argv[1])) : default_depth;
+    const auto locals = argc > 2 ? static_cast<std::size_t>(std::atol(argv[2])) : default_locals;
+
+    if (depth == 0 || locals < 2)
+    {
+        std::cerr << "Usage: symbol_table_bench [depth] [locals per block]\n";
+        return EXIT_FAILURE;
+    }
+
+    const auto work = generate_workload(depth, locals);
+
+    std::vector<bool> flat_answers;
+    std::vector<bool> chained_answers;
+
+    const auto flat_time = cc::bench::time_ms([&] {
+        for (std::size_t i = 0; i < repetitions; i++)
+        {
+            auto table = flat_symbol_table();
+            flat_answers = replay(work.operations, table);
+        }
+    });
+
+    const auto chained_time = cc::bench::time_ms([&] {
+        for (std::size_t i = 0; i < repetitions; i++)
+        {
+            auto scopes = std::deque<chained_symbol_table>(1);
+            chained_answers = replay(work.operations, scopes);
+        }
+    });
+
+    if (flat_answers != chained_answers)
+    {
+        std::cerr << "The symbol tables disagree\n";
+        return EXIT_FAILURE;
+    }
+
+    const auto file_id = cc::source_manager::instance().add_file("symbol_table_bench.c", work.source);
+    auto lexer = cc::lexer(file_id);
+    const auto tokens = lexer.lex_buffer();
+
+    auto parser = cc::parser(tokens);
+    const auto parse_time = cc::bench::time_ms([&] { parser.parse_contents(); });
+
+    if (!parser.diagnostics().empty())
+    {
+        for (const auto &diagnostic : parser.diagnostics())
+        {
+            std::cerr << diagnostic.to_string() << '\n';
+        }
+        return EXIT_FAILURE;
+    }
+
+    const auto operation_count = static_cast<double>(work.operations.size() * repetitions);
+
+    cc::bench::print_row("operations", static_cast<double>(work.operations.size()), "");
+    cc::bench::print_row("flat table", flat_time * 1e6 / operation_count, "ns/op");
+    cc::bench::print_row("chained tables", chained_time * 1e6 / operation_count, "ns/op");
+    cc::bench::print_row("parse", parse_time, "ms");
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,313 @@
+#include "bench_util.h"
+#include "file_buffer.h"
+#include "lexer.h"
+#include "parser.h"
+#include "source_manager.h"
+#include "syntax/syntax_visitor.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+constexpr std::string_view usage = "Usage: visitor_bench <file> [repetitions]\n";
+
+constexpr std::size_t default_repetitions = 10;
+
+/**
+ * @brief What the benchmarked passes compute, so that both ways of writing them can be checked
+ *        against each other.
+ */
+struct statistics
+{
+    std::size_t nodes = 0;
+    std::size_t binary_expressions = 0;
+    std::size_t resolved_references = 0;
+    std::size_t deepest_block = 0;
+    std::size_t deepest_expression = 0;
+    std::uint64_t literal_sum = 0;
+
+    bool operator==(const statistics &) const = default;
+};
+
+/**
+ * @brief A pass whose callbacks are virtual functions, called from a recursive walk over
+ *        `children()`. This is how a pass has to be written without `syntax_visitor`. The passes
+ *        are run from a list, like a pass manager would, so the calls stay indirect.
+ */
+class virtual_pass
+{
+public:
+    virtual ~virtual_pass() = default;
+
+    virtual void enter(const cc::syntax_node &node) = 0;
+    virtual void leave(const cc::syntax_node &node) = 0;
+};
+
+void walk(virtual_pass &pass, const cc::syntax_node &node)
+{
+    pass.enter(node);
+
+    for (const auto *child : node.children())
+    {
+        walk(pass, *child);
+    }
+
+    pass.leave(node);
+}
+
+class virtual_statistics_pass : public virtual_pass
+{
+public:
+    explicit virtual_statistics_pass(statistics &result)
+        : result_(result)
+    {
+    }
+
+    void enter(const cc::syntax_node &node) override
+    {
+        switch (node.type())
+        {
+        case cc::syntax_type::integer_literal:
+            result_.literal_sum += static_cast<const cc::integer_literal &>(node).value();
+            break;
+        case cc::syntax_type::binary_expression:
+            result_.binary_expressions++;
+            break;
+        case cc::syntax_type::declaration_reference_expression:
+            if (static_cast<const cc::declaration_reference_expression &>(node).declaration())
+            {
+                result_.resolved_references++;
+            }
+            break;
+        case cc::syntax_type::compound_statement:
+            depth_++;
+            result_.deepest_block = std::max(result_.deepest_block, depth_);
+            break;
+        default:
+            break;
+        }
+    }
+
+    void leave(const cc::syntax_node &node) override
+    {
+        if (node.type() == cc::syntax_type::compound_statement)
+        {
+            depth_--;
+        }
+
+        result_.nodes++;
+    }
+
+private:
+    statistics &result_;
+    std::size_t depth_ = 0;
+};
+
+class virtual_expression_depth_pass : public virtual_pass
+{
+public:
+    explicit virtual_expression_depth_pass(statistics &result)
+        : result_(result)
+    {
+    }
+
+    void enter(const cc::syntax_node &node) override
+    {
+        if (is_expression(node))
+        {
+            depth_++;
+            result_.deepest_expression = std::max(result_.deepest_expression, depth_);
+        }
+    }
+
+    void leave(const cc::syntax_node &node) override
+    {
+        if (is_expression(node))
+        {
+            depth_--;
+        }
+    }
+
+private:
+    static bool is_expression(const cc::syntax_node &node)
+    {
+        switch (node.type())
+        {
+        case cc::syntax_type::integer_literal:
+        case cc::syntax_type::double_literal:
+        case cc::syntax_type::float_literal:
+        case cc::syntax_type::string_literal:
+        case cc::syntax_type::char_literal:
+        case cc::syntax_type::binary_expression:
+        case cc::syntax_type::parenthesized_expression:
+        case cc::syntax_type::declaration_reference_expression:
+        case cc::syntax_type::error:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    statistics &result_;
+    std::size_t depth_ = 0;
+};
+
+class static_statistics_pass : public cc::syntax_visitor<static_statistics_pass>
+{
+public:
+    explicit static_statistics_pass(statistics &result)
+        : result_(result)
+    {
+    }
+
+    void enter(const cc::integer_literal &node)
+    {
+        result_.literal_sum += node.value();
+    }
+
+    void enter(const cc::binary_expression &)
+    {
+        result_.binary_expressions++;
+    }
+
+    void enter(const cc::declaration_reference_expression &node)
+    {
+        if (node.declaration())
+        {
+            result_.resolved_references++;
+        }
+    }
+
+    void enter(const cc::compound_statement &)
+    {
+        depth_++;
+        result_.deepest_block = std::max(result_.deepest_block, depth_);
+    }
+
+    void leave(const cc::compound_statement &)
+    {
+        depth_--;
+        result_.nodes++;
+    }
+
+    void leave(const cc::syntax_node &)
+    {
+        result_.nodes++;
+    }
+
+private:
+    statistics &result_;
+    std::size_t depth_ = 0;
+};
+
+class static_expression_depth_pass : public cc::syntax_visitor<static_expression_depth_pass>
+{
+public:
+    explicit static_expression_depth_pass(statistics &result)
+        : result_(result)
+    {
+    }
+
+    void enter(const cc::expression &)
+    {
+        depth_++;
+        result_.deepest_expression = std::max(result_.deepest_expression, depth_);
+    }
+
+    void leave(const cc::expression &)
+    {
+        depth_--;
+    }
+
+private:
+    statistics &result_;
+    std::size_t depth_ = 0;
+};
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << usage;
+        return EXIT_FAILURE;
+    }
+
+    const auto repetitions = argc > 2 ? static_cast<std::size_t>(std::atol(argv[2])) : default_repetitions;
+    if (repetitions == 0)
+    {
+        std::cerr << usage;
+        return EXIT_FAILURE;
+    }
+
+    const auto file = cc::bench::open_file(argv[1], usage);
+    if (!file)
+    {
+        return EXIT_FAILURE;
+    }
+    const auto file_id = cc::source_manager::instance().add_file(argv[1], file->contents());
+    auto lexer = cc::lexer(file_id);
+    const auto tokens = lexer.lex_buffer();
+
+    auto parser = cc::parser(tokens);
+    const auto tree = parser.parse_contents();
+
+    if (!parser.diagnostics().empty())
+    {
+        for (const auto &diagnostic : parser.diagnostics())
+        {
+            std::cerr << diagnostic.to_string() << '\n';
+        }
+        return EXIT_FAILURE;
+    }
+
+    statistics virtual_result;
+    statistics static_result;
+
+    const auto virtual_time = cc::bench::time_ms([&] {
+        for (std::size_t i = 0; i < repetitions; i++)
+        {
+            virtual_result = {};
+
+            std::vector<std::unique_ptr<virtual_pass>> pipeline;
+            pipeline.push_back(std::make_unique<virtual_statistics_pass>(virtual_result));
+            pipeline.push_back(std::make_unique<virtual_expression_depth_pass>(virtual_result));
+
+            for (const auto &pass : pipeline)
+            {
+                walk(*pass, *tree);
+            }
+        }
+    });
+
+    const auto static_time = cc::bench::time_ms([&] {
+        for (std::size_t i = 0; i < repetitions; i++)
+        {
+            static_result = {};
+            static_statistics_pass(static_result).traverse(*tree);
+            static_expression_depth_pass(static_result).traverse(*tree);
+        }
+    });
+
+    if (virtual_result != static_result)
+    {
+        std::cerr << "The passes disagree\n";
+        return EXIT_FAILURE;
+    }
+
+    cc::bench::print_row("nodes", static_cast<double>(static_result.nodes), "");
+    cc::bench::print_row("deepest block", static_cast<double>(static_result.deepest_block), "");
+    cc::bench::print_row("deepest expression", static_cast<double>(static_result.deepest_expression), "");
+    cc::bench::print_row("virtual passes", virtual_time / static_cast<double>(repetitions), "ms");
+    cc::bench::print_row("static passes", static_time / static_cast<double>(repetitions), "ms");
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,20 @@
+#include "arena.h"
+
+#include <algorithm>
+
+void *cc::arena::allocate_block(std::size_t size, std::size_t alignment)
+{
+    // Oversized allocations get a block to themselves, with enough slack to align them
+    const auto capacity = std::max(block_size, size + alignment);
+
+    blocks_.push_back(std::make_unique_for_overwrite<std::byte[]>(capacity));
+    capacity_ += capacity;
+
+    void *memory = blocks_.back().get();
+    std::size_t space = capacity;
+    std::align(alignment, size, memory, space);
+
+    cursor_ = static_cast<std::byte *>(memory) + size;
+    remaining_ = space - size;
+    return memory;
+}
@@ -0,0 +1,132 @@
+#ifndef C_COMPILER_ARENA_H
+#define C_COMPILER_ARENA_H
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace cc {
+
+/**
+ * @brief A bump-pointer allocator. Objects are carved out of large blocks one after the other and
+ *        are all released together when the arena is destroyed.
+ *
+ *        Destructors of objects created in an arena are never run, so they must not own anything
+ *        that needs to be released, such as a `std::vector` or a `std::unique_ptr`.
+ */
+class arena
+{
+public:
+    arena() = default;
+
+    arena(const arena &) = delete;
+    arena &operator=(const arena &) = delete;
+
+    // A moved-from arena starts over with no blocks, rather than allocating from blocks it no
+    // longer owns
+    arena(arena &&other) noexcept
+        : blocks_(std::move(other.blocks_))
+        , cursor_(std::exchange(other.cursor_, nullptr))
+        , remaining_(std::exchange(other.remaining_, 0))
+        , capacity_(std::exchange(other.capacity_, 0))
+    {
+    }
+
+    arena &operator=(arena &&other) noexcept
+    {
+        blocks_ = std::move(other.blocks_);
+        cursor_ = std::exchange(other.cursor_, nullptr);
+        remaining_ = std::exchange(other.remaining_, 0);
+        capacity_ = std::exchange(other.capacity_, 0);
+        return *this;
+    }
+
+    /**
+     * @brief  Allocates uninitialized memory. The memory stays where it is when the arena is moved.
+     *
+     * @param[in] size      The number of bytes to allocate.
+     * @param[in] alignment The alignment of the memory, which must be a power of 2.
+     * @return              The allocated memory.
+     */
+    void *allocate(std::size_t size, std::size_t alignment)
+    {
+        void *memory = cursor_;
+        std::size_t space = remaining_;
+
+        if (!std::align(alignment, size, memory, space))
+        {
+            return allocate_block(size, alignment);
+        }
+
+        cursor_ = static_cast<std::byte *>(memory) + size;
+        remaining_ = space - size;
+        return memory;
+    }
+
+    /**
+     * @brief  Constructs an object in the arena.
+     */
+    template<typename T, typename... Args>
+    T *create(Args &&...args)
+    {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief  Copies a range of trivially copyable values into the arena.
+     */
+    template<typename T>
+    std::span<T> copy(std::span<const T> values)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values can be copied into an arena");
+
+        if (values.empty())
+        {
+            return {};
+        }
+
+        auto *destination = static_cast<T *>(allocate(values.size_bytes(), alignof(T)));
+        std::uninitialized_copy(values.begin(), values.end(), destination);
+        return {destination, values.size()};
+    }
+
+    /**
+     * @brief  Takes over the memory of another arena, so that objects created in it live as long
+     *         as this arena does. `other` is left empty.
+     */
+    void absorb(arena &&other)
+    {
+        blocks_.insert(blocks_.end(), std::make_move_iterator(other.blocks_.begin()), std::make_move_iterator(other.blocks_.end()));
+        capacity_ += other.capacity_;
+        other = arena();
+    }
+
+    /**
+     * @brief  The number of bytes of memory held by the arena, including unused space at the end of
+     *         each block.
+     */
+    std::size_t capacity() const
+    {
+        return capacity_;
+    }
+
+private:
+    void *allocate_block(std::size_t size, std::size_t alignment);
+
+private:
+    static constexpr std::size_t block_size = 64 * 1024;
+
+    std::vector<std::unique_ptr<std::byte[]>> blocks_;
+    std::byte *cursor_ = nullptr;
+    std::size_t remaining_ = 0;
+    std::size_t capacity_ = 0;
+};
+
+} // namespace cc
+
+#endif
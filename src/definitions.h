@@ -1,6 +1,9 @@
 #ifndef C_COMPILER_DEFINITIONS_H
 #define C_COMPILER_DEFINITIONS_H
 
+#include "token_type.h"
+
+#include <array>
 #include <string_view>
 
 namespace cc::keyworddefs {
@@ -27,6 +30,38 @@ inline constexpr std::string_view continue_keyword = "continue";
 
 inline constexpr std::string_view return_keyword = "return";
 
+/**
+ * @brief A keyword and the token type it is lexed as.
+ */
+struct keyword
+{
+    std::string_view text;
+    cc::token_type type = cc::token_type::unknown;
+};
+
+// Every keyword above, with its token type. The lexer's keyword lookup table is generated from this
+// list at compile time.
+inline constexpr std::array keywords = {
+    keyword{char_keyword, cc::token_type::char_keyword},
+    keyword{int_keyword, cc::token_type::int_keyword},
+    keyword{double_keyword, cc::token_type::double_keyword},
+    keyword{float_keyword, cc::token_type::float_keyword},
+    keyword{struct_keyword, cc::token_type::struct_keyword},
+    keyword{enum_keyword, cc::token_type::enum_keyword},
+    keyword{void_keyword, cc::token_type::void_keyword},
+    keyword{short_keyword, cc::token_type::short_keyword},
+    keyword{long_keyword, cc::token_type::long_keyword},
+    keyword{const_keyword, cc::token_type::const_keyword},
+    keyword{static_keyword, cc::token_type::static_keyword},
+    keyword{if_keyword, cc::token_type::if_keyword},
+    keyword{else_keyword, cc::token_type::else_keyword},
+    keyword{for_keyword, cc::token_type::for_keyword},
+    keyword{while_keyword, cc::token_type::while_keyword},
+    keyword{break_keyword, cc::token_type::break_keyword},
+    keyword{continue_keyword, cc::token_type::continue_keyword},
+    keyword{return_keyword, cc::token_type::return_keyword},
+};
+
 } // namespace cc::keyworddefs
 
 namespace cc::chardefs {
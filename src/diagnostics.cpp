@@ -0,0 +1,16 @@
+#include "diagnostics.h"
+
+std::string cc::diagnostic::to_string() const
+{
+    const auto &file = cc::source_manager::instance().file(location.file);
+    const auto position = file.position(location.offset);
+
+    std::string result(file.name());
+    result += ':';
+    result += std::to_string(position.line);
+    result += ':';
+    result += std::to_string(position.column);
+    result += ": error: ";
+    result += message;
+    return result;
+}
@@ -0,0 +1,64 @@
+#ifndef C_COMPILER_DIAGNOSTICS_H
+#define C_COMPILER_DIAGNOSTICS_H
+
+#include "source_manager.h"
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cc {
+
+struct diagnostic
+{
+    cc::source_location location;
+    std::string message;
+
+    /**
+     * @brief  Formats the diagnostic as `file:line:column: error: message`.
+     */
+    std::string to_string() const;
+};
+
+/**
+ * @brief Collects the errors found while compiling, so that every error in a file is reported at
+ *        once instead of only the first.
+ */
+class diagnostics
+{
+public:
+    using const_iterator = std::vector<cc::diagnostic>::const_iterator;
+
+    void error(cc::source_location location, std::string message)
+    {
+        diagnostics_.push_back({location, std::move(message)});
+    }
+
+    bool empty() const
+    {
+        return diagnostics_.empty();
+    }
+
+    std::size_t size() const
+    {
+        return diagnostics_.size();
+    }
+
+    const_iterator begin() const
+    {
+        return diagnostics_.begin();
+    }
+
+    const_iterator end() const
+    {
+        return diagnostics_.end();
+    }
+
+private:
+    std::vector<cc::diagnostic> diagnostics_;
+};
+
+} // namespace cc
+
+#endif
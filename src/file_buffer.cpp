@@ -0,0 +1,164 @@
+#include "file_buffer.h"
+
+#include <cerrno>
+#include <system_error>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CCOMPILER_HAS_MMAP
+#include <array>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <iterator>
+#endif
+
+namespace {
+
+[[noreturn]] void throw_file_error(const std::string &what, const std::string &file_name)
+{
+    throw std::system_error(errno, std::generic_category(), what + " '" + file_name + "'");
+}
+
+#ifdef CCOMPILER_HAS_MMAP
+class file_descriptor
+{
+public:
+    explicit file_descriptor(int fd)
+        : fd_(fd)
+    {
+    }
+
+    ~file_descriptor()
+    {
+        if (fd_ >= 0)
+        {
+            ::close(fd_);
+        }
+    }
+
+    file_descriptor(const file_descriptor &) = delete;
+    file_descriptor(file_descriptor &&) = delete;
+    file_descriptor &operator=(const file_descriptor &) = delete;
+    file_descriptor &operator=(file_descriptor &&) = delete;
+
+    int get() const
+    {
+        return fd_;
+    }
+
+private:
+    int fd_;
+};
+
+constexpr std::size_t read_chunk_size = 64 * 1024;
+#endif
+
+} // namespace
+
+cc::file_buffer::file_buffer(const std::string &file_name)
+    : mapping_(nullptr)
+    , mapping_size_(0)
+{
+#ifdef CCOMPILER_HAS_MMAP
+    const auto file = file_descriptor(::open(file_name.c_str(), O_RDONLY));
+
+    if (file.get() < 0)
+    {
+        throw_file_error("Cannot open", file_name);
+    }
+
+    struct stat status = {};
+    if (::fstat(file.get(), &status) != 0)
+    {
+        throw_file_error("Cannot stat", file_name);
+    }
+
+    // Empty files cannot be mapped, and neither can pipes or devices
+    if (S_ISREG(status.st_mode) && status.st_size > 0)
+    {
+        const auto size = static_cast<std::size_t>(status.st_size);
+
+        if (void *mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file.get(), 0); mapping != MAP_FAILED)
+        {
+            mapping_ = mapping;
+            mapping_size_ = size;
+
+            // The lexer reads the file front to back exactly once. This is only a hint, so failure
+            // is harmless.
+            ::posix_madvise(mapping_, mapping_size_, POSIX_MADV_SEQUENTIAL);
+            return;
+        }
+    }
+
+    std::array<char, read_chunk_size> chunk;
+    while (true)
+    {
+        const auto count = ::read(file.get(), chunk.data(), chunk.size());
+
+        if (count == 0)
+        {
+            break;
+        }
+
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            throw_file_error("Cannot read", file_name);
+        }
+
+        fallback_.append(chunk.data(), static_cast<std::size_t>(count));
+    }
+#else
+    auto in = std::ifstream(file_name, std::ios::binary);
+
+    if (!in)
+    {
+        throw_file_error("Cannot open", file_name);
+    }
+
+    fallback_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+#endif
+}
+
+cc::file_buffer::~file_buffer()
+{
+    unmap();
+}
+
+cc::file_buffer::file_buffer(file_buffer &&other) noexcept
+    : mapping_(std::exchange(other.mapping_, nullptr))
+    , mapping_size_(std::exchange(other.mapping_size_, 0))
+    , fallback_(std::move(other.fallback_))
+{
+}
+
+cc::file_buffer &cc::file_buffer::operator=(file_buffer &&other) noexcept
+{
+    if (this != &other)
+    {
+        unmap();
+        mapping_ = std::exchange(other.mapping_, nullptr);
+        mapping_size_ = std::exchange(other.mapping_size_, 0);
+        fallback_ = std::move(other.fallback_);
+    }
+    return *this;
+}
+
+void cc::file_buffer::unmap()
+{
+#ifdef CCOMPILER_HAS_MMAP
+    if (mapping_)
+    {
+        ::munmap(mapping_, mapping_size_);
+        mapping_ = nullptr;
+        mapping_size_ = 0;
+    }
+#endif
+}
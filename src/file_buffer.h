@@ -0,0 +1,57 @@
+#ifndef C_COMPILER_FILE_BUFFER_H
+#define C_COMPILER_FILE_BUFFER_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace cc {
+
+/**
+ * @brief Read-only contents of a file. Regular files are memory-mapped, so their contents are read
+ *        straight from the page cache without being copied. Pipes and other special files, which
+ *        cannot be mapped, are read into an owned buffer instead.
+ *
+ *        Files are only mapped on POSIX systems. Elsewhere, including on Windows, every file is
+ *        read into the owned buffer as a whole.
+ */
+class file_buffer
+{
+public:
+    /**
+     * @brief Opens and maps (or reads) a file.
+     *
+     * @param[in] file_name The path of the file to open.
+     * @throw std::system_error If the file cannot be opened or read.
+     */
+    explicit file_buffer(const std::string &file_name);
+
+    ~file_buffer();
+
+    file_buffer(const file_buffer &) = delete;
+    file_buffer &operator=(const file_buffer &) = delete;
+    file_buffer(file_buffer &&other) noexcept;
+    file_buffer &operator=(file_buffer &&other) noexcept;
+
+    std::string_view contents() const
+    {
+        return mapping_ ? std::string_view(static_cast<const char *>(mapping_), mapping_size_) : fallback_;
+    }
+
+    bool is_mapped() const
+    {
+        return mapping_ != nullptr;
+    }
+
+private:
+    void unmap();
+
+private:
+    void *mapping_;
+    std::size_t mapping_size_;
+    std::string fallback_;
+};
+
+} // namespace cc
+
+#endif
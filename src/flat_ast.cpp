@@ -0,0 +1,210 @@
+#include "flat_ast.h"
+
+#include "syntax_tree_builder.h"
+#include "syntax/binary_expression.h"
+#include "syntax/compound_statement.h"
+#include "syntax/declaration_reference_expression.h"
+#include "syntax/function_declaration.h"
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief The state of a conversion from one kind of tree to the other. References may come before
+ *        the declaration they refer to, so they are resolved once every declaration has been built.
+ */
+template<typename From, typename Builder>
+struct conversion
+{
+    Builder builder;
+    std::unordered_map<From, typename Builder::node> built;
+    std::vector<std::pair<typename Builder::node, From>> references;
+
+    void resolve_references()
+    {
+        for (const auto &[reference, declaration] : references)
+        {
+            if (const auto it = built.find(declaration); it != built.end())
+            {
+                builder.resolve(reference, it->second);
+            }
+        }
+    }
+};
+
+using to_class_tree = conversion<cc::node_index, cc::syntax_tree_builder>;
+using to_flat_tree = conversion<const cc::syntax_node *, cc::flat_ast_builder>;
+
+cc::syntax_tree_builder::node build_node(const cc::flat_ast &ast, cc::node_index index, to_class_tree &conversion);
+
+cc::syntax_tree_builder::node convert(const cc::flat_ast &ast, cc::node_index index, to_class_tree &conversion)
+{
+    const auto n = build_node(ast, index, conversion);
+
+    switch (ast.kind(index))
+    {
+    case cc::syntax_type::variable_declaration:
+    case cc::syntax_type::function_declaration:
+        conversion.built.emplace(index, n);
+        break;
+    case cc::syntax_type::declaration_reference_expression:
+        if (ast.declaration(index) != cc::invalid_node)
+        {
+            conversion.references.emplace_back(n, ast.declaration(index));
+        }
+        break;
+    default:
+        break;
+    }
+
+    return n;
+}
+
+cc::syntax_tree_builder::node build_node(const cc::flat_ast &ast, cc::node_index index, to_class_tree &conversion)
+{
+    using node = cc::syntax_tree_builder::node;
+
+    auto &builder = conversion.builder;
+
+    std::vector<node> children;
+    for (const auto child : ast.children(index))
+    {
+        children.push_back(convert(ast, child, conversion));
+    }
+
+    const auto child = children.empty() ? cc::syntax_tree_builder::none : children.front();
+    const auto token = ast.token(index);
+
+    switch (ast.kind(index))
+    {
+    case cc::syntax_type::integer_literal:
+    case cc::syntax_type::double_literal:
+    case cc::syntax_type::float_literal:
+    case cc::syntax_type::string_literal:
+    case cc::syntax_type::char_literal:
+        return builder.literal(token);
+    case cc::syntax_type::binary_expression:
+        return builder.binary_expression(token, children[0], children[1]);
+    case cc::syntax_type::parenthesized_expression:
+        return builder.parenthesized_expression(token, child);
+    case cc::syntax_type::declaration_reference_expression:
+        return builder.declaration_reference_expression(token);
+    case cc::syntax_type::variable_declaration:
+        return builder.variable_declaration(token, ast.tokens()[token.index() + 1], child);
+    case cc::syntax_type::function_declaration:
+        return builder.function_declaration(token, ast.tokens()[token.index() + 1], child,
+                                            ast.has_flag(index, cc::flat_ast::redeclared_flag));
+    case cc::syntax_type::return_statement:
+        return builder.return_statement(token, child);
+    case cc::syntax_type::compound_statement:
+        return builder.compound_statement(token, children, ast.has_flag(index, cc::flat_ast::returns_flag));
+    case cc::syntax_type::error:
+        return builder.error(token);
+    default:
+        throw std::runtime_error("Unexpected node in flat syntax tree");
+    }
+}
+
+cc::flat_ast_builder::node build_node(const cc::syntax_node &tree, to_flat_tree &conversion);
+
+cc::flat_ast_builder::node convert(const cc::syntax_node &tree, to_flat_tree &conversion)
+{
+    const auto n = build_node(tree, conversion);
+
+    switch (tree.type())
+    {
+    case cc::syntax_type::variable_declaration:
+    case cc::syntax_type::function_declaration:
+        conversion.built.emplace(&tree, n);
+        break;
+    case cc::syntax_type::declaration_reference_expression:
+        if (const auto *declaration = static_cast<const cc::declaration_reference_expression &>(tree).declaration())
+        {
+            conversion.references.emplace_back(n, declaration);
+        }
+        break;
+    default:
+        break;
+    }
+
+    return n;
+}
+
+cc::flat_ast_builder::node build_node(const cc::syntax_node &tree, to_flat_tree &conversion)
+{
+    using node = cc::flat_ast_builder::node;
+
+    auto &builder = conversion.builder;
+
+    std::vector<node> children;
+    for (const auto *child : tree.children())
+    {
+        children.push_back(convert(*child, conversion));
+    }
+
+    const auto child = children.empty() ? cc::flat_ast_builder::none : children.front();
+    const auto token = tree.trigger_token();
+
+    // Declarations only store the type specifier; the identifier is the token after it
+    switch (tree.type())
+    {
+    case cc::syntax_type::integer_literal:
+    case cc::syntax_type::double_literal:
+    case cc::syntax_type::float_literal:
+    case cc::syntax_type::string_literal:
+    case cc::syntax_type::char_literal:
+        return builder.literal(token);
+    case cc::syntax_type::binary_expression:
+        return builder.binary_expression(static_cast<const cc::binary_expression &>(tree).operator_token(), children[0], children[1]);
+    case cc::syntax_type::parenthesized_expression:
+        return builder.parenthesized_expression(token, child);
+    case cc::syntax_type::declaration_reference_expression:
+        return builder.declaration_reference_expression(token);
+    case cc::syntax_type::variable_declaration:
+        return builder.variable_declaration(token, token, child);
+    case cc::syntax_type::function_declaration:
+        return builder.function_declaration(token, token, child,
+                                            static_cast<const cc::function_declaration &>(tree).is_redeclared());
+    case cc::syntax_type::return_statement:
+        return builder.return_statement(token, child);
+    case cc::syntax_type::compound_statement:
+        return builder.compound_statement(token, children, static_cast<const cc::compound_statement &>(tree).returns());
+    case cc::syntax_type::error:
+        return builder.error(token);
+    default:
+        throw std::runtime_error("Unexpected node in syntax tree");
+    }
+}
+
+} // namespace
+
+std::unique_ptr<cc::syntax_node> cc::to_syntax_tree(const cc::flat_ast &ast)
+{
+    auto conversion = to_class_tree();
+
+    std::vector<cc::syntax_tree_builder::node> declarations;
+    for (const auto declaration : ast.children(ast.root()))
+    {
+        declarations.push_back(convert(ast, declaration, conversion));
+    }
+
+    conversion.resolve_references();
+    return conversion.builder.translation_unit(ast.token(ast.root()), declarations);
+}
+
+cc::flat_ast cc::to_flat_ast(const cc::syntax_node &root)
+{
+    auto conversion = to_flat_tree();
+
+    std::vector<cc::flat_ast_builder::node> declarations;
+    for (const auto *declaration : root.children())
+    {
+        declarations.push_back(convert(*declaration, conversion));
+    }
+
+    conversion.resolve_references();
+    return conversion.builder.translation_unit(root.trigger_token(), declarations);
+}
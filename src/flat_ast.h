@@ -0,0 +1,441 @@
+#ifndef C_COMPILER_FLAT_AST_H
+#define C_COMPILER_FLAT_AST_H
+
+#include "source_manager.h"
+#include "token_buffer.h"
+#include "token_type.h"
+#include "syntax/syntax_node.h"
+#include "syntax/syntax_type.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace cc {
+
+class body_parser;
+
+using node_index = std::uint32_t;
+
+/**
+ * @brief The index of a node that does not exist, e.g. the next sibling of a last child.
+ */
+inline constexpr cc::node_index invalid_node = std::numeric_limits<cc::node_index>::max();
+
+/**
+ * @brief A node of a `flat_ast`: plain data that refers to other nodes and to tokens by index.
+ */
+struct flat_node
+{
+    cc::syntax_type kind;
+    std::uint8_t flags;
+
+    // The index of the token the node was built from. For declarations this is the type specifier,
+    // which is followed by the identifier. For binary expressions it is the operator.
+    std::uint32_t token;
+
+    // A declaration reference has no children. Its `first_child` is the declaration it refers to
+    // instead, or `invalid_node` if it did not resolve to one.
+    cc::node_index first_child;
+    cc::node_index next_sibling;
+};
+
+static_assert(std::is_trivially_copyable_v<cc::flat_node>, "Flat nodes must be plain data");
+
+/**
+ * @brief A syntax tree stored as one contiguous array of `flat_node` records. Children come before
+ *        their parents, so the root is the last node. The children of a node are reached through
+ *        `first_child` and then `next_sibling`.
+ *
+ *        Compared with a tree of `syntax_node` objects, walking it involves no virtual calls and
+ *        little pointer chasing, and it can be copied or written out as a single block of memory.
+ *
+ *        If parsing ran into syntax errors, the array may also hold nodes that were built before an
+ *        error was found and are not reachable from the root.
+ */
+class flat_ast
+{
+public:
+    /**
+     * @brief Set in `flat_node::flags` of a compound statement that contains a return statement.
+     */
+    static constexpr std::uint8_t returns_flag = 1 << 0;
+
+    /**
+     * @brief Set in `flat_node::flags` of a function declaration that redeclares a function.
+     */
+    static constexpr std::uint8_t redeclared_flag = 1 << 1;
+
+    /**
+     * @brief Set in `flat_node::flags` of a function definition whose body was skipped by
+     *        `basic_parser::parse_declarations()`. The body is not in the tree.
+     */
+    static constexpr std::uint8_t deferred_flag = 1 << 2;
+
+    /**
+     * @brief Iterates over the children of a node, in order. It only needs the node records, so it
+     *        also walks trees that are stored elsewhere, such as in a `serialized_ast`.
+     */
+    class child_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = cc::node_index;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = cc::node_index;
+
+        child_iterator() = default;
+
+        child_iterator(const cc::flat_node *nodes, cc::node_index index)
+            : nodes_(nodes)
+            , index_(index)
+        {
+        }
+
+        cc::node_index operator*() const
+        {
+            return index_;
+        }
+
+        child_iterator &operator++()
+        {
+            index_ = nodes_[index_].next_sibling;
+            return *this;
+        }
+
+        child_iterator operator++(int)
+        {
+            auto previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const child_iterator &other) const
+        {
+            return index_ == other.index_;
+        }
+
+    private:
+        const cc::flat_node *nodes_ = nullptr;
+        cc::node_index index_ = cc::invalid_node;
+    };
+
+    struct child_range
+    {
+        child_iterator first;
+        child_iterator last;
+
+        child_iterator begin() const
+        {
+            return first;
+        }
+
+        child_iterator end() const
+        {
+            return last;
+        }
+    };
+
+    /**
+     * @param[in] tokens        The tokens that nodes refer to.
+     * @param[in] nodes         The nodes, root last.
+     * @param[in] retained      Owns `tokens`, if nothing else does.
+     * @param[in] retained_file Keeps the file of `tokens` registered, if nothing else does.
+     */
+    flat_ast(const cc::token_buffer &tokens,
+             std::vector<cc::flat_node> nodes,
+             std::unique_ptr<cc::token_buffer> retained = nullptr,
+             cc::scoped_file retained_file = {})
+        : tokens_(&tokens)
+        , retained_(std::move(retained))
+        , retained_file_(std::move(retained_file))
+        , nodes_(std::move(nodes))
+    {
+    }
+
+    cc::node_index root() const
+    {
+        return static_cast<cc::node_index>(nodes_.size() - 1);
+    }
+
+    std::size_t size() const
+    {
+        return nodes_.size();
+    }
+
+    const cc::flat_node &operator[](cc::node_index index) const
+    {
+        return nodes_[index];
+    }
+
+    std::span<const cc::flat_node> nodes() const
+    {
+        return nodes_;
+    }
+
+    const cc::token_buffer &tokens() const
+    {
+        return *tokens_;
+    }
+
+    cc::syntax_type kind(cc::node_index index) const
+    {
+        return nodes_[index].kind;
+    }
+
+    child_range children(cc::node_index index) const
+    {
+        const auto &record = nodes_[index];
+        const auto first = record.kind == cc::syntax_type::declaration_reference_expression ? cc::invalid_node : record.first_child;
+        return {{nodes_.data(), first}, {nodes_.data(), cc::invalid_node}};
+    }
+
+    /**
+     * @brief  The declaration that a declaration reference refers to, or `invalid_node` if it did
+     *         not resolve to one.
+     */
+    cc::node_index declaration(cc::node_index reference) const
+    {
+        return nodes_[reference].first_child;
+    }
+
+    /**
+     * @brief  The token stored in the node. See `flat_node::token`.
+     */
+    cc::token_ref token(cc::node_index index) const
+    {
+        return (*tokens_)[nodes_[index].token];
+    }
+
+    /**
+     * @brief  The token that a `syntax_node` would report as its trigger token. This is the stored
+     *         token except for binary expressions, which start at their left operand.
+     */
+    cc::token_ref trigger_token(cc::node_index index) const
+    {
+        while (nodes_[index].kind == cc::syntax_type::binary_expression)
+        {
+            index = nodes_[index].first_child;
+        }
+        return token(index);
+    }
+
+    bool has_flag(cc::node_index index, std::uint8_t flag) const
+    {
+        return (nodes_[index].flags & flag) != 0;
+    }
+
+private:
+    const cc::token_buffer *tokens_;
+    std::unique_ptr<cc::token_buffer> retained_;
+    cc::scoped_file retained_file_;
+    std::vector<cc::flat_node> nodes_;
+};
+
+/**
+ * @brief Builds a `flat_ast` for the parser. See `syntax_tree_builder` for how builders are used.
+ */
+class flat_ast_builder
+{
+public:
+    using node = cc::node_index;
+    using result = cc::flat_ast;
+
+    static constexpr node none = cc::invalid_node;
+
+    node literal(cc::token_ref token)
+    {
+        switch (token.type())
+        {
+        case cc::token_type::char_literal:
+            return add(cc::syntax_type::char_literal, token);
+        case cc::token_type::integer_literal:
+            return add(cc::syntax_type::integer_literal, token);
+        case cc::token_type::double_literal:
+            return add(cc::syntax_type::double_literal, token);
+        case cc::token_type::float_literal:
+            return add(cc::syntax_type::float_literal, token);
+        case cc::token_type::string_literal:
+            return add(cc::syntax_type::string_literal, token);
+        default:
+            throw std::runtime_error("Hit unreachable branch in flat_ast_builder::literal()");
+        }
+    }
+
+    node parenthesized_expression(cc::token_ref open, node expression)
+    {
+        return add(cc::syntax_type::parenthesized_expression, open, {&expression, 1});
+    }
+
+    node declaration_reference_expression(cc::token_ref identifier)
+    {
+        return add(cc::syntax_type::declaration_reference_expression, identifier);
+    }
+
+    node binary_expression(cc::token_ref op, node left, node right)
+    {
+        const node operands[] = {left, right};
+        return add(cc::syntax_type::binary_expression, op, operands);
+    }
+
+    void resolve(node reference, node declaration)
+    {
+        nodes_[reference].first_child = declaration;
+    }
+
+    node return_statement(cc::token_ref keyword, node expression)
+    {
+        return add(cc::syntax_type::return_statement, keyword, optional_child(expression));
+    }
+
+    node compound_statement(cc::token_ref open, std::span<const node> statements, bool returns)
+    {
+        return add(cc::syntax_type::compound_statement, open, statements, returns ? cc::flat_ast::returns_flag : std::uint8_t(0));
+    }
+
+    node variable_declaration(cc::token_ref type_specifier, cc::token_ref, node initializer)
+    {
+        return add(cc::syntax_type::variable_declaration, type_specifier, optional_child(initializer));
+    }
+
+    node function_declaration(cc::token_ref type_specifier, cc::token_ref, node definition, bool is_redeclared)
+    {
+        return add(cc::syntax_type::function_declaration, type_specifier, optional_child(definition),
+                   is_redeclared ? cc::flat_ast::redeclared_flag : std::uint8_t(0));
+    }
+
+    /**
+     * @brief A function definition whose body was skipped. A flat tree cannot grow once it is built,
+     *        so the body is never parsed and only `deferred_flag` records that there is one.
+     */
+    node deferred_function_declaration(cc::token_ref type_specifier,
+                                       cc::token_ref,
+                                       cc::token_ref,
+                                       bool is_redeclared,
+                                       cc::body_parser &)
+    {
+        const auto flags = is_redeclared ? cc::flat_ast::redeclared_flag : std::uint8_t(0);
+        return add(cc::syntax_type::function_declaration, type_specifier, {},
+                   static_cast<std::uint8_t>(flags | cc::flat_ast::deferred_flag));
+    }
+
+    node error(cc::token_ref token)
+    {
+        return add(cc::syntax_type::error, token);
+    }
+
+    /**
+     * @brief  Takes over a subtree that was built by another builder, with the tokens of the same
+     *         buffer. Subtrees must be adopted in the order `other` built them.
+     * @return The root of the subtree in this builder.
+     */
+    node adopt(flat_ast_builder &other, node root)
+    {
+        // Everything `other` built since the last adopted subtree belongs to this one
+        const auto first = other.adopted_;
+        const auto base = static_cast<node>(nodes_.size());
+        const auto relocate = [&](node n) { return n == none ? none : n - first + base; };
+
+        for (auto i = first; i <= root; i++)
+        {
+            auto record = other.nodes_[i];
+            record.first_child = relocate(record.first_child);
+            record.next_sibling = relocate(record.next_sibling);
+            nodes_.push_back(record);
+        }
+
+        other.adopted_ = root + 1;
+        adopted_from_ = first;
+        adopted_to_ = base;
+        return relocate(root);
+    }
+
+    /**
+     * @brief  Where a node of the subtree that was adopted last ended up in this builder.
+     */
+    node adopted(node n) const
+    {
+        return n == none ? none : n - adopted_from_ + adopted_to_;
+    }
+
+    /**
+     * @brief  Builds the root and hands over every node built so far. The builder cannot be used
+     *         again afterwards.
+     *
+     * @param[in] tokens Owns the tokens that nodes refer to, if nothing else does.
+     */
+    result translation_unit(cc::token_ref first,
+                            std::span<const node> declarations,
+                            std::unique_ptr<cc::token_buffer> tokens = nullptr)
+    {
+        add(cc::syntax_type::translation_unit_declaration, first, declarations);
+        return {first.buffer(), std::move(nodes_), std::move(tokens)};
+    }
+
+    cc::syntax_type kind(node n) const
+    {
+        return nodes_[n].kind;
+    }
+
+    bool returns(node n) const
+    {
+        return (nodes_[n].flags & cc::flat_ast::returns_flag) != 0;
+    }
+
+private:
+    static std::span<const node> optional_child(const node &child)
+    {
+        return {&child, child == none ? std::size_t(0) : std::size_t(1)};
+    }
+
+    node add(cc::syntax_type kind, cc::token_ref token, std::span<const node> children = {}, std::uint8_t flags = 0)
+    {
+        for (std::size_t i = 1; i < children.size(); i++)
+        {
+            nodes_[children[i - 1]].next_sibling = children[i];
+        }
+
+        nodes_.push_back({
+            .kind         = kind,
+            .flags        = flags,
+            .token        = static_cast<std::uint32_t>(token.index()),
+            .first_child  = children.empty() ? cc::invalid_node : children.front(),
+            .next_sibling = cc::invalid_node,
+        });
+        return static_cast<node>(nodes_.size() - 1);
+    }
+
+private:
+    std::vector<cc::flat_node> nodes_;
+
+    // The nodes before this one have been adopted by another builder
+    node adopted_ = 0;
+
+    // Where the subtree adopted last came from in the other builder, and where it went in this one
+    node adopted_from_ = 0;
+    node adopted_to_ = 0;
+};
+
+/**
+ * @brief  Converts a flat syntax tree into a tree of `syntax_node` objects with the same structure.
+ *         The tree refers to the tokens of `ast`, so `ast` must outlive it.
+ */
+std::unique_ptr<cc::syntax_node> to_syntax_tree(const cc::flat_ast &ast);
+
+/**
+ * @brief  Converts a tree of `syntax_node` objects, as returned by the parser, into a flat syntax
+ *         tree. The flat tree refers to the same tokens as `root`, so `root` must outlive it.
+ */
+cc::flat_ast to_flat_ast(const cc::syntax_node &root);
+
+} // namespace cc
+
+#endif
@@ -0,0 +1,99 @@
+#include "identifier_table.h"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+
+cc::identifier_table &cc::identifier_table::instance()
+{
+    static identifier_table table;
+    return table;
+}
+
+cc::identifier_id cc::identifier_table::intern(std::string_view text)
+{
+    // Keep the load factor at or below 1/2 so that probe sequences stay short
+    if (2 * (texts_.size() + 1) > slots_.size())
+    {
+        grow();
+    }
+
+    const auto hash = static_cast<std::uint32_t>(std::hash<std::string_view>()(text));
+    const auto mask = slots_.size() - 1;
+
+    for (auto index = hash & mask; ; index = (index + 1) & mask)
+    {
+        auto &candidate = slots_[index];
+
+        if (candidate.id == cc::invalid_identifier)
+        {
+            if (texts_.size() >= cc::invalid_identifier)
+            {
+                throw std::length_error("Too many distinct identifiers");
+            }
+
+            const auto id = static_cast<cc::identifier_id>(texts_.size());
+            texts_.push_back(store(text));
+            candidate = {hash, id};
+            return id;
+        }
+
+        if (candidate.hash == hash && texts_[candidate.id] == text)
+        {
+            return candidate.id;
+        }
+    }
+}
+
+std::string_view cc::identifier_table::store(std::string_view text)
+{
+    char *destination = nullptr;
+
+    if (text.size() > block_size)
+    {
+        // Identifiers longer than a block get a block to themselves, and the next identifier starts
+        // a fresh block
+        blocks_.push_back(std::make_unique<char[]>(text.size()));
+        destination = blocks_.back().get();
+        block_used_ = block_size;
+    }
+    else
+    {
+        if (blocks_.empty() || text.size() > block_size - block_used_)
+        {
+            blocks_.push_back(std::make_unique<char[]>(block_size));
+            block_used_ = 0;
+        }
+
+        destination = blocks_.back().get() + block_used_;
+        block_used_ += text.size();
+    }
+
+    std::copy(text.begin(), text.end(), destination);
+    return {destination, text.size()};
+}
+
+void cc::identifier_table::grow()
+{
+    const auto capacity = std::max(initial_capacity, 2 * slots_.size());
+    auto slots = std::vector<slot>(capacity, {0, cc::invalid_identifier});
+
+    const auto mask = capacity - 1;
+    for (const auto &entry : slots_)
+    {
+        if (entry.id == cc::invalid_identifier)
+        {
+            continue;
+        }
+
+        auto index = entry.hash & mask;
+        while (slots[index].id != cc::invalid_identifier)
+        {
+            index = (index + 1) & mask;
+        }
+        slots[index] = entry;
+    }
+
+    slots_ = std::move(slots);
+}
@@ -0,0 +1,91 @@
+#ifndef C_COMPILER_IDENTIFIER_TABLE_H
+#define C_COMPILER_IDENTIFIER_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace cc {
+
+using identifier_id = std::uint32_t;
+
+/**
+ * @brief The id of tokens that are not identifiers.
+ */
+inline constexpr cc::identifier_id invalid_identifier = std::numeric_limits<cc::identifier_id>::max();
+
+/**
+ * @brief Interns identifier text. Every distinct identifier is assigned a dense id, starting at 0,
+ *        so identifiers can be compared, hashed or used as array indices as plain integers.
+ *
+ *        The text of every identifier is copied into storage owned by the table, so ids stay valid
+ *        after the source they came from is gone. A table is not thread-safe; the global instance
+ *        is only meant to be filled from one thread at a time.
+ */
+class identifier_table
+{
+public:
+    identifier_table() = default;
+
+    identifier_table(const identifier_table &) = delete;
+    identifier_table &operator=(const identifier_table &) = delete;
+    identifier_table(identifier_table &&) = default;
+    identifier_table &operator=(identifier_table &&) = default;
+
+    /**
+     * @brief  The table that identifiers are interned into unless a lexer is given its own.
+     */
+    static identifier_table &instance();
+
+    /**
+     * @brief  Looks up `text`, adding it if it has not been seen before.
+     *
+     * @param[in] text The text of an identifier.
+     * @return         The id of `text`.
+     */
+    cc::identifier_id intern(std::string_view text);
+
+    /**
+     * @param[in] id An id returned by `intern()`.
+     * @return       The text of the identifier.
+     */
+    std::string_view text(cc::identifier_id id) const
+    {
+        return texts_[id];
+    }
+
+    std::size_t size() const
+    {
+        return texts_.size();
+    }
+
+private:
+    // The hash is kept next to the id so that probing rarely has to look at the text
+    struct slot
+    {
+        std::uint32_t hash;
+        std::uint32_t id;
+    };
+
+    std::string_view store(std::string_view text);
+    void grow();
+
+private:
+    static constexpr std::size_t initial_capacity = 1024;
+    static constexpr std::size_t block_size = 64 * 1024;
+
+    // Open addressing with linear probing. Empty slots have an id of `invalid_identifier`.
+    std::vector<slot> slots_;
+    std::vector<std::string_view> texts_;
+
+    // Identifier text is packed into large blocks rather than allocated one string at a time
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    std::size_t block_used_ = block_size;
+};
+
+} // namespace cc
+
+#endif
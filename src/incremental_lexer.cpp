@@ -0,0 +1,138 @@
+#include "incremental_lexer.h"
+
+#include <algorithm>
+
+cc::incremental_lexer::incremental_lexer(cc::file_id file, cc::lexer_engine engine)
+    : engine_(engine)
+    , file_(file)
+{
+    auto lexer = cc::lexer(file, engine);
+    tokens_ = lexer.lex_contents();
+
+    const auto source = cc::source_manager::instance().file(file).text();
+    for (auto &token : tokens_)
+    {
+        take_decoded_text(token, source);
+    }
+}
+
+cc::relexed_range cc::incremental_lexer::apply_edit(std::string_view new_source, const cc::text_edit &edit)
+{
+    const auto old_source = cc::source_manager::instance().file(file_).text();
+    cc::source_manager::instance().replace_file(file_, new_source);
+
+    const auto delta = static_cast<std::int64_t>(edit.inserted_length) - static_cast<std::int64_t>(edit.removed_length);
+    const auto edit_end = static_cast<std::int64_t>(edit.offset) + edit.inserted_length;
+
+    // The token that starts last before the edit may run into it, or be joined to it, so lexing
+    // starts there. If there is no such token, the edit may be in leading whitespace or comments.
+    const auto next = std::lower_bound(tokens_.begin(), tokens_.end(), edit.offset, [](const cc::token &token, std::uint32_t offset) {
+        return token.location.offset < offset;
+    });
+    const auto first = next == tokens_.begin() ? std::size_t(0) : static_cast<std::size_t>(next - tokens_.begin()) - 1;
+    const auto start = next == tokens_.begin() ? std::uint32_t(0) : tokens_[first].location.offset;
+
+    auto lexer = cc::lexer(file_, start, new_source.size(), engine_);
+    std::vector<cc::token> relexed;
+
+    // Past the inserted text, the new buffer is the old one moved by `delta`. Once a new token
+    // starts where an old one did, every token after it is the same as before.
+    auto resync = tokens_.size();
+    auto candidate = first;
+    while (true)
+    {
+        auto token = lexer.next();
+
+        if (token.location.offset >= edit_end)
+        {
+            const auto old_offset = static_cast<std::int64_t>(token.location.offset) - delta;
+            while (candidate < tokens_.size() && tokens_[candidate].location.offset < old_offset)
+            {
+                candidate++;
+            }
+            if (candidate < tokens_.size() && tokens_[candidate].location.offset == old_offset)
+            {
+                resync = candidate;
+                break;
+            }
+        }
+
+        take_decoded_text(token, new_source);
+        relexed.push_back(token);
+
+        if (token.type == cc::token_type::eof)
+        {
+            break;
+        }
+    }
+
+    // Every token that is kept has to be moved over to the new buffer
+    const auto retarget = [&](cc::token &token, std::uint32_t offset) {
+        if (!is_decoded(token, old_source))
+        {
+            token.text = new_source.substr(offset, token.text.size());
+        }
+        token.location.offset = offset;
+    };
+
+    for (std::size_t i = 0; i < first; i++)
+    {
+        retarget(tokens_[i], tokens_[i].location.offset);
+    }
+    for (auto i = resync; i < tokens_.size(); i++)
+    {
+        retarget(tokens_[i], static_cast<std::uint32_t>(tokens_[i].location.offset + delta));
+    }
+
+    const auto removed_count = resync - first;
+    for (auto i = first; i < resync; i++)
+    {
+        if (is_decoded(tokens_[i], old_source))
+        {
+            decoded_count_--;
+        }
+    }
+
+    const auto common = std::min(removed_count, relexed.size());
+    const auto replaced = tokens_.begin() + static_cast<std::ptrdiff_t>(first);
+    std::copy_n(relexed.begin(), common, replaced);
+    if (relexed.size() > removed_count)
+    {
+        tokens_.insert(replaced + static_cast<std::ptrdiff_t>(common), relexed.begin() + static_cast<std::ptrdiff_t>(common), relexed.end());
+    }
+    else
+    {
+        tokens_.erase(replaced + static_cast<std::ptrdiff_t>(common), replaced + static_cast<std::ptrdiff_t>(removed_count));
+    }
+
+    const auto dropped_count = literals_.size() - decoded_count_;
+    if (dropped_count > std::max(decoded_count_, tokens_.size() / 8))
+    {
+        collect_literals(new_source);
+    }
+
+    return {first, removed_count, relexed.size()};
+}
+
+void cc::incremental_lexer::take_decoded_text(cc::token &token, std::string_view source)
+{
+    if (is_decoded(token, source))
+    {
+        token.text = literals_.emplace_back(token.text);
+        decoded_count_++;
+    }
+}
+
+void cc::incremental_lexer::collect_literals(std::string_view source)
+{
+    std::deque<std::string> live;
+    for (auto &token : tokens_)
+    {
+        if (is_decoded(token, source))
+        {
+            token.text = live.emplace_back(token.text);
+        }
+    }
+
+    literals_ = std::move(live);
+}
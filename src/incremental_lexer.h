@@ -0,0 +1,124 @@
+#ifndef C_COMPILER_INCREMENTAL_LEXER_H
+#define C_COMPILER_INCREMENTAL_LEXER_H
+
+#include "lexer.h"
+#include "source_manager.h"
+#include "token.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cc {
+
+/**
+ * @brief A change to a source buffer: `removed_length` bytes at `offset` were replaced by
+ *        `inserted_length` new bytes.
+ */
+struct text_edit
+{
+    std::uint32_t offset;
+    std::uint32_t removed_length;
+    std::uint32_t inserted_length;
+};
+
+/**
+ * @brief The tokens that an edit replaced: the old tokens [`first`, `first + removed_count`) became
+ *        the new tokens [`first`, `first + inserted_count`). Every other token kept its type and
+ *        text, although the ones after the edit have moved.
+ */
+struct relexed_range
+{
+    std::size_t first;
+    std::size_t removed_count;
+    std::size_t inserted_count;
+};
+
+/**
+ * @brief Keeps the tokens of a buffer that is being edited up to date without lexing the whole
+ *        buffer again after every edit.
+ *
+ *        The lexer carries no state from one token to the next, so an edit can only change the
+ *        tokens from the last one that starts before the edit up to the first one that starts at the
+ *        same place, relative to the unchanged text, as an old token did. Only that stretch is lexed
+ *        again; the tokens after it are the old ones, moved by the change in length.
+ */
+class incremental_lexer
+{
+public:
+    /**
+     * @brief Lexes the whole of `file`.
+     */
+    explicit incremental_lexer(cc::file_id file, cc::lexer_engine engine = cc::lexer_engine::table_driven);
+
+    incremental_lexer(const incremental_lexer &) = delete;
+    incremental_lexer &operator=(const incremental_lexer &) = delete;
+
+    /**
+     * @brief  The tokens of the current buffer, terminated by an `eof` token. Token text refers to
+     *         the current buffer or to storage owned by this object.
+     */
+    const std::vector<cc::token> &tokens() const
+    {
+        return tokens_;
+    }
+
+    cc::file_id file() const
+    {
+        return file_;
+    }
+
+    /**
+     * @brief  Updates the tokens after an edit. The file keeps its id: the `source_manager` entry
+     *         is pointed at the edited buffer. Once this returns, nothing refers to the previous
+     *         buffer any more and it may be freed.
+     *
+     * @param[in] new_source The edited buffer, which must outlive every use of `file()`. It must
+     *                       be the previous buffer with `edit` applied.
+     * @param[in] edit       The change that was made.
+     * @return               The tokens that were replaced.
+     * @throw std::length_error If the edited buffer is too large for 32-bit offsets.
+     */
+    cc::relexed_range apply_edit(std::string_view new_source, const cc::text_edit &edit);
+
+private:
+    /**
+     * @brief Whether the text of a token is decoded, rather than a view of `source`.
+     */
+    static bool is_decoded(const cc::token &token, std::string_view source)
+    {
+        return token.text.data() != source.data() + token.location.offset;
+    }
+
+    /**
+     * @brief Moves decoded literal text out of the lexer that produced it, which is not kept.
+     */
+    void take_decoded_text(cc::token &token, std::string_view source);
+
+    /**
+     * @brief Copies the text of every decoded token into fresh storage, dropping the text of tokens
+     *        that edits have replaced. It is run once the dropped text outweighs both the text in
+     *        use and an eighth of the tokens, so it takes amortized constant time per literal and
+     *        keeps memory in proportion to the buffer rather than to the number of edits.
+     */
+    void collect_literals(std::string_view source);
+
+private:
+    cc::lexer_engine engine_;
+    cc::file_id file_;
+    std::vector<cc::token> tokens_;
+
+    // Text of decoded literals. A deque never relocates its elements, so views into them stay valid.
+    // Text of replaced tokens stays behind until collect_literals() runs.
+    std::deque<std::string> literals_;
+
+    // How many entries of `literals_` a token still refers to
+    std::size_t decoded_count_ = 0;
+};
+
+} // namespace cc
+
+#endif
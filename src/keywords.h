@@ -0,0 +1,134 @@
+#ifndef C_COMPILER_KEYWORDS_H
+#define C_COMPILER_KEYWORDS_H
+
+#include "definitions.h"
+#include "token_type.h"
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+#include <type_traits>
+
+namespace cc {
+
+namespace detail {
+
+using token_type_value = std::underlying_type_t<cc::token_type>;
+
+inline constexpr cc::token_type first_keyword_type = cc::token_type::char_keyword;
+inline constexpr cc::token_type last_keyword_type = cc::token_type::return_keyword;
+
+inline constexpr std::size_t keyword_type_count = static_cast<std::size_t>(
+    static_cast<token_type_value>(last_keyword_type) - static_cast<token_type_value>(first_keyword_type) + 1);
+
+/**
+ * @return Whether `cc::keyworddefs::keywords` pairs every keyword token type with exactly one word.
+ */
+constexpr bool lists_every_keyword_type()
+{
+    std::array<bool, keyword_type_count> is_listed{};
+
+    for (const auto &keyword : cc::keyworddefs::keywords)
+    {
+        if (keyword.type < first_keyword_type || keyword.type > last_keyword_type)
+        {
+            return false;
+        }
+
+        const auto index = static_cast<std::size_t>(static_cast<token_type_value>(keyword.type) -
+                                                    static_cast<token_type_value>(first_keyword_type));
+        if (is_listed[index])
+        {
+            return false;
+        }
+        is_listed[index] = true;
+    }
+
+    return cc::keyworddefs::keywords.size() == keyword_type_count;
+}
+
+static_assert(lists_every_keyword_type(), "cc::keyworddefs::keywords must list every keyword token type once");
+
+/**
+ * @brief Hashes a word by its length and its first and last chars. The multipliers are searched for
+ *        at compile time so that no two keywords share a slot.
+ */
+struct keyword_hash
+{
+    static constexpr std::size_t table_size = 64;
+
+    std::size_t first_multiplier;
+    std::size_t last_multiplier;
+
+    constexpr std::size_t operator()(std::string_view word) const
+    {
+        const auto first = static_cast<std::size_t>(static_cast<unsigned char>(word.front()));
+        const auto last = static_cast<std::size_t>(static_cast<unsigned char>(word.back()));
+        return (first * first_multiplier + last * last_multiplier + word.size()) % table_size;
+    }
+
+    constexpr bool is_perfect() const
+    {
+        std::array<bool, table_size> is_used{};
+
+        for (const auto &keyword : cc::keyworddefs::keywords)
+        {
+            const auto slot = (*this)(keyword.text);
+            if (is_used[slot])
+            {
+                return false;
+            }
+            is_used[slot] = true;
+        }
+
+        return true;
+    }
+};
+
+constexpr keyword_hash find_keyword_hash()
+{
+    for (std::size_t first_multiplier = 1; first_multiplier < keyword_hash::table_size; first_multiplier++)
+    {
+        for (std::size_t last_multiplier = 0; last_multiplier < keyword_hash::table_size; last_multiplier++)
+        {
+            if (const auto hash = keyword_hash{first_multiplier, last_multiplier}; hash.is_perfect())
+            {
+                return hash;
+            }
+        }
+    }
+
+    // Not a constant expression, so running out of candidates is a compile-time error
+    throw "No perfect hash exists for cc::keyworddefs::keywords; increase keyword_hash::table_size";
+}
+
+inline constexpr keyword_hash keyword_hasher = find_keyword_hash();
+
+inline constexpr auto keyword_table = [] {
+    std::array<cc::keyworddefs::keyword, keyword_hash::table_size> table{};
+
+    for (const auto &keyword : cc::keyworddefs::keywords)
+    {
+        table[keyword_hasher(keyword.text)] = keyword;
+    }
+
+    return table;
+}();
+
+} // namespace detail
+
+/**
+ * @brief  Classifies a word as a keyword.
+ *
+ * @param[in] word A non-empty identifier.
+ * @return         The keyword's `token_type`, or `token_type::unknown` if `word` is not a keyword.
+ */
+constexpr cc::token_type keyword_type(std::string_view word)
+{
+    const auto &entry = detail::keyword_table[detail::keyword_hasher(word)];
+    return entry.text == word ? entry.type : cc::token_type::unknown;
+}
+
+} // namespace cc
+
+#endif
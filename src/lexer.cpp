@@ -1,217 +1,453 @@
 #include "lexer.h"
 
+#include "keywords.h"
+#include "lexer_tables.h"
+#include "scan.h"
 #include "token.h"
 #include "token_type.h"
 
-#include <cctype>
-#include <unordered_map>
+#include <bit>
+#include <charconv>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
 
-std::vector<cc::token> cc::lexer::lex_contents()
+namespace {
+
+template <typename T>
+std::optional<T> parse_number(std::string_view text, int base = 10)
 {
-    std::vector<cc::token> tokens;
+    T value{};
+    const char *last = text.data() + text.size();
 
-    while (current() != cc::chardefs::eof)
+    std::from_chars_result result;
+    if constexpr (std::is_integral_v<T>)
     {
-        tokens.push_back(next_token());
+        result = std::from_chars(text.data(), last, value, base);
+    }
+    else
+    {
+        result = std::from_chars(text.data(), last, value, std::chars_format::general);
     }
 
-    tokens.push_back(create_token(cc::token_type::eof));
-    return tokens;
+    // The lexer has already checked the shape of the literal, so this only fails on values that are
+    // out of range, or on octal literals that contain an 8 or a 9
+    if (result.ec != std::errc() || result.ptr != last)
+    {
+        return std::nullopt;
+    }
+
+    return value;
 }
 
-cc::token cc::lexer::next_token()
+/**
+ * @brief  Converts the text of a numeric literal to its binary value.
+ * @return The bit pattern of the value, or nothing if the literal is malformed.
+ */
+std::optional<std::uint64_t> decode_numeric_literal(cc::token_type type, std::string_view text)
 {
-    // Cache starting column of token
-    start_column_ = column_;
+    switch (type)
+    {
+    case cc::token_type::integer_literal:
+        {
+            // A leading 0 makes an integer literal octal
+            const bool is_octal = text.size() > 1 && text.front() == '0';
+            return parse_number<std::uint64_t>(is_octal ? text.substr(1) : text, is_octal ? 8 : 10);
+        }
+    case cc::token_type::double_literal:
+        {
+            const auto value = parse_number<double>(text);
+            return value ? std::optional(std::bit_cast<std::uint64_t>(*value)) : std::nullopt;
+        }
+    case cc::token_type::float_literal:
+        {
+            // Parse straight to float without the suffix. Going through double would round twice.
+            text.remove_suffix(1);
+            const auto value = parse_number<float>(text);
+            return value ? std::optional<std::uint64_t>(std::bit_cast<std::uint32_t>(*value)) : std::nullopt;
+        }
+    default:
+        return std::nullopt;
+    }
+}
+
+} // namespace
 
-    // Cache first char
-    const char first_char = current();
+cc::token cc::lexer::create_numeric_token(cc::token_type type)
+{
+    auto token = create_token(type);
 
-    // Skip CR since no modern OS uses CR for newline
-    if (first_char == cc::chardefs::cr)
+    if (const auto value = decode_numeric_literal(type, token.text))
     {
-        advance();
-        return next_token();
+        token.value = *value;
     }
-
-    if (first_char == cc::chardefs::lf)
+    else
     {
-        handle_newline();
-        return next_token();
+        token.type = cc::token_type::unknown;
     }
 
-    // Nothing to lex if current() == eof
-    if (first_char == cc::chardefs::eof)
+    return token;
+}
+
+std::vector<cc::token> cc::lexer::lex_contents()
+{
+    std::vector<cc::token> tokens;
+
+    do
     {
-        return create_token(cc::token_type::eof);
-    }
+        tokens.push_back(next());
+    } while (tokens.back().type != cc::token_type::eof);
 
-    // Look for keyword or literal
-    if (first_char == cc::chardefs::quote)
+    return tokens;
+}
+
+cc::token_buffer cc::lexer::lex_buffer()
+{
+    auto tokens = cc::token_buffer(file_);
+
+    // A rough guess at the token density of typical C code, which saves most of the reallocations
+    tokens.reserve(source_.size() / 4);
+
+    for (auto token = next(); ; token = next())
     {
-        consume();
-        return read_string();
+        tokens.push_back(token);
+
+        if (token.type == cc::token_type::eof)
+        {
+            break;
+        }
     }
-    if (std::isalpha(first_char) || first_char == cc::chardefs::underscore)
+
+    return tokens;
+}
+
+cc::token cc::lexer::next()
+{
+    if (lookahead_count_ == 0)
     {
-        return read_identifier();
+        return lex_token();
     }
-    if (std::isdigit(first_char))
+
+    auto token = lookahead_[lookahead_start_];
+    lookahead_start_ = (lookahead_start_ + 1) % max_lookahead;
+    lookahead_count_--;
+    return token;
+}
+
+const cc::token &cc::lexer::peek(std::size_t lookahead)
+{
+    if (lookahead >= max_lookahead)
     {
-        return read_integer();
+        throw std::out_of_range("Lexer lookahead is limited to " + std::to_string(max_lookahead) + " tokens");
     }
-    if (std::isspace(first_char))
+
+    while (lookahead_count_ <= lookahead)
     {
-        skip_space();
-        return next_token();
+        lookahead_[(lookahead_start_ + lookahead_count_) % max_lookahead] = lex_token();
+        lookahead_count_++;
     }
 
-    // Not keyword nor literal, so look for operator or separator
-    switch (first_char)
+    return lookahead_[(lookahead_start_ + lookahead) % max_lookahead];
+}
+
+cc::token cc::lexer::next_table_driven_token()
+{
+    using cc::lexer_tables::index_of;
+    using cc::lexer_tables::state;
+
+    while (true)
     {
-    case cc::chardefs::plus:
-        {
-            consume();
-            return create_token(cc::token_type::plus);
-        }
-    case cc::chardefs::dash:
-        {
-            consume();
-            return create_token(cc::token_type::minus);
-        }
-    case cc::chardefs::asterisk:
-        {
-            consume();
-            return create_token(cc::token_type::asterisk);
-        }
-    case cc::chardefs::forward_slash:
-        {
-            consume();
-            return create_token(cc::token_type::forward_slash);
-        }
-    case cc::chardefs::equal:
+        begin_token();
+
+        // Run the automaton until it stops, without touching the lexer state
+        auto token_state = state::start;
+        std::size_t end = index_;
+
+        while (true)
         {
-            consume();
-            return create_token(cc::token_type::assign);
+            const char c = end < source_.size() ? source_[end] : cc::chardefs::eof;
+            const auto char_class = cc::lexer_tables::char_classes[index_of(c)];
+            const auto next_state = cc::lexer_tables::transitions[index_of(token_state)][index_of(char_class)];
+
+            if (next_state == state::stop)
+            {
+                break;
+            }
+
+            token_state = next_state;
+            end++;
+
+            // Identifiers can only loop back to themselves, so their tail is skipped in bulk
+            if (token_state == state::identifier)
+            {
+                end = static_cast<std::size_t>(cc::scan::find_identifier_end(source_.data() + end, source_end()) -
+                                               source_.data());
+                break;
+            }
         }
-    case cc::chardefs::open_paren:
+
+        switch (token_state)
         {
-            consume();
-            return create_token(cc::token_type::open_parenthesis);
+        case state::whitespace:
+            {
+                skip_space();
+                continue;
+            }
+        case state::string:
+            {
+                consume();
+                return read_string();
+            }
+        case state::punctuator:
+            {
+                if (const auto skipped = skip_comment(); skipped == comment::skipped)
+                {
+                    continue;
+                }
+                else if (skipped == comment::unterminated)
+                {
+                    return create_token(cc::token_type::unknown);
+                }
+                break;
+            }
+        case state::eof:
+            {
+                return create_token(cc::token_type::eof);
+            }
+        default:
+            break;
         }
-    case cc::chardefs::close_paren:
+
+        consume_run(end - index_);
+
+        switch (token_state)
         {
-            consume();
-            return create_token(cc::token_type::close_parenthesis);
+        case state::identifier:
+            {
+                if (const auto type = get_keyword_type(); type != cc::token_type::unknown)
+                {
+                    return create_token(type);
+                }
+                return create_identifier_token();
+            }
+        case state::punctuator:
+            {
+                return create_token(cc::lexer_tables::punctuator_types[index_of(source_[token_start_])]);
+            }
+        case state::integer:
+        case state::fraction:
+        case state::exponent_digits:
+        case state::float_suffix:
+            {
+                return create_numeric_token(cc::lexer_tables::accepted_types[index_of(token_state)]);
+            }
+        default:
+            return create_token(cc::lexer_tables::accepted_types[index_of(token_state)]);
         }
-    case cc::chardefs::open_brace:
+    }
+}
+
+cc::token cc::lexer::next_token()
+{
+    // Whitespace is skipped by looping rather than recursing, so long runs of blank lines cannot
+    // exhaust the stack
+    while (true)
+    {
+        // Mark the start of the token in the source
+        begin_token();
+
+        // Cache first char
+        const char first_char = current();
+
+        // Skip CR since no modern OS uses CR for newline
+        if (first_char == cc::chardefs::cr)
         {
-            consume();
-            return create_token(cc::token_type::open_brace);
+            advance();
+            continue;
         }
-    case cc::chardefs::close_brace:
+
+        if (first_char == cc::chardefs::lf)
         {
-            consume();
-            return create_token(cc::token_type::close_brace);
+            advance();
+            continue;
         }
-    case cc::chardefs::open_angle:
+
+        // Nothing to lex if current() == eof
+        if (first_char == cc::chardefs::eof)
         {
-            consume();
-            return create_token(cc::token_type::open_angle);
+            return create_token(cc::token_type::eof);
         }
-    case cc::chardefs::close_angle:
+
+        // Look for keyword or literal
+        if (first_char == cc::chardefs::quote)
         {
             consume();
-            return create_token(cc::token_type::close_angle);
+            return read_string();
         }
-    case cc::chardefs::open_square:
+        if (cc::scan::is_identifier_start(first_char))
         {
-            consume();
-            return create_token(cc::token_type::open_square);
+            return read_identifier();
         }
-    case cc::chardefs::close_square:
+        if (cc::scan::is_digit(first_char))
         {
-            consume();
-            return create_token(cc::token_type::close_square);
+            return read_integer();
         }
-    case cc::chardefs::comma:
+        if (cc::scan::is_space(first_char))
         {
-            consume();
-            return create_token(cc::token_type::comma);
+            skip_space();
+            continue;
         }
-    case cc::chardefs::semicolon:
+
+        // Not keyword nor literal, so look for operator or separator
+        switch (first_char)
         {
-            consume();
-            return create_token(cc::token_type::semicolon);
+        case cc::chardefs::plus:
+            {
+                consume();
+                return create_token(cc::token_type::plus);
+            }
+        case cc::chardefs::dash:
+            {
+                consume();
+                return create_token(cc::token_type::minus);
+            }
+        case cc::chardefs::asterisk:
+            {
+                consume();
+                return create_token(cc::token_type::asterisk);
+            }
+        case cc::chardefs::forward_slash:
+            {
+                if (const auto skipped = skip_comment(); skipped == comment::skipped)
+                {
+                    continue;
+                }
+                else if (skipped == comment::unterminated)
+                {
+                    return create_token(cc::token_type::unknown);
+                }
+
+                consume();
+                return create_token(cc::token_type::forward_slash);
+            }
+        case cc::chardefs::equal:
+            {
+                consume();
+                return create_token(cc::token_type::assign);
+            }
+        case cc::chardefs::open_paren:
+            {
+                consume();
+                return create_token(cc::token_type::open_parenthesis);
+            }
+        case cc::chardefs::close_paren:
+            {
+                consume();
+                return create_token(cc::token_type::close_parenthesis);
+            }
+        case cc::chardefs::open_brace:
+            {
+                consume();
+                return create_token(cc::token_type::open_brace);
+            }
+        case cc::chardefs::close_brace:
+            {
+                consume();
+                return create_token(cc::token_type::close_brace);
+            }
+        case cc::chardefs::open_angle:
+            {
+                consume();
+                return create_token(cc::token_type::open_angle);
+            }
+        case cc::chardefs::close_angle:
+            {
+                consume();
+                return create_token(cc::token_type::close_angle);
+            }
+        case cc::chardefs::open_square:
+            {
+                consume();
+                return create_token(cc::token_type::open_square);
+            }
+        case cc::chardefs::close_square:
+            {
+                consume();
+                return create_token(cc::token_type::close_square);
+            }
+        case cc::chardefs::comma:
+            {
+                consume();
+                return create_token(cc::token_type::comma);
+            }
+        case cc::chardefs::semicolon:
+            {
+                consume();
+                return create_token(cc::token_type::semicolon);
+            }
+        default:
+            break;
         }
-    default:
-        break;
-    }
 
-    // Could not identify the token
-    return read_unknown();
+        // Could not identify the token
+        return read_unknown();
+    }
 }
 
 cc::token cc::lexer::read_string()
 {
     // TODO: Report missing closing quote as error
 
-    // clang-format off
-    while (current() != cc::chardefs::quote &&
-           current() != cc::chardefs::backslash &&
-           current() != cc::chardefs::cr &&
-           current() != cc::chardefs::lf &&
-           current() != cc::chardefs::eof)
+    while (true)
     {
-        consume();
-    }
-    // clang-format on
+        // Skip ahead to the next quote, backslash, newline or eof
+        consume_run(static_cast<std::size_t>(cc::scan::find_string_special(cursor(), source_end()) - cursor()));
 
-    const char breaking_char = current();
+        const char breaking_char = current();
 
-    switch (breaking_char)
-    {
-    case cc::chardefs::cr:
-        {
-            advance();
-            return read_string();
-        }
-    case cc::chardefs::lf:
-        {
-            handle_newline();
-            break;
-        }
-    case cc::chardefs::quote:
-        {
-            consume();
-            break;
-        }
-    case cc::chardefs::backslash:
-        {
-            return read_escaped();
-        }
-    case cc::chardefs::eof:
+        switch (breaking_char)
         {
-            return create_token(cc::token_type::unknown);
+        case cc::chardefs::cr:
+            {
+                discard();
+                break;
+            }
+        case cc::chardefs::lf:
+            {
+                // The newline is not part of the string, so create the token before skipping it
+                auto token = create_token(cc::token_type::string_literal);
+                advance();
+                return token;
+            }
+        case cc::chardefs::quote:
+            {
+                consume();
+                return create_token(cc::token_type::string_literal);
+            }
+        case cc::chardefs::backslash:
+            {
+                read_escaped();
+                break;
+            }
+        default:
+            {
+                // Hit eof before the closing quote
+                return create_token(cc::token_type::unknown);
+            }
         }
-    default:
-        break;
     }
-
-    return create_token(cc::token_type::string_literal);
 }
 
-cc::token cc::lexer::read_escaped()
+void cc::lexer::read_escaped()
 {
-    // Skip the backslash for now. We will determine
-    // whether it should be part of the string later.
-    advance();
-
-    const char first_char = current();
+    // Look past the backslash to determine whether it should be part of the string
+    const char escaped_char = index_ + 1 < source_.size() ? source_[index_ + 1] : cc::chardefs::eof;
 
     // TODO: Handle octal and hex
 
-    switch (first_char)
+    switch (escaped_char)
     {
     case cc::chardefs::single_quote:
     case cc::chardefs::double_quote:
@@ -225,55 +461,86 @@ cc::token cc::lexer::read_escaped()
     case 't':
     case 'v':
         {
-            buffer_ << cc::chardefs::back_slash;
+            // Simple escape sequences are kept verbatim
+            consume();
             consume();
             break;
         }
     case cc::chardefs::cr:
-        {
-            advance();
-            return read_escaped();
-        }
     case cc::chardefs::lf:
         {
-            handle_newline();
+            // Line continuation: drop the backslash and the newline
+            discard();
+            if (current() == cc::chardefs::cr)
+            {
+                discard();
+            }
+            if (current() == cc::chardefs::lf)
+            {
+                discard();
+            }
             break;
         }
     default:
-        break;
+        {
+            // If no cases matched, ignore backslash
+            discard();
+            break;
+        }
     }
-
-    // If no cases matched, ignore backslash
-
-    return read_string();
 }
 
 cc::token cc::lexer::read_identifier()
 {
-    while (std::isalnum(current()) || current() == cc::chardefs::underscore)
-    {
-        consume();
-    }
+    consume_run(static_cast<std::size_t>(cc::scan::find_identifier_end(cursor(), source_end()) - cursor()));
 
     if (const auto type = get_keyword_type(); type != cc::token_type::unknown)
     {
         return create_token(type);
     }
 
-    return create_token(cc::token_type::identifier);
+    return create_identifier_token();
 }
 
-void cc::lexer::skip_space()
+cc::lexer::comment cc::lexer::skip_comment()
 {
-    while (std::isspace(current()))
+    if (current() != cc::chardefs::forward_slash || index_ + 1 >= source_.size())
     {
-        advance();
+        return comment::none;
     }
+
+    const char *body = cursor() + 2;
+
+    switch (source_[index_ + 1])
+    {
+    case cc::chardefs::forward_slash:
+        {
+            // The terminating LF is left for the whitespace skipper
+            index_ = static_cast<std::size_t>(cc::scan::find_line_comment_end(body, source_end()) - source_.data());
+            return comment::skipped;
+        }
+    case cc::chardefs::asterisk:
+        {
+            const char *end = cc::scan::find_block_comment_end(body, source_end());
+            const bool is_closed = end != source_end() || (end - body >= 2 && end[-2] == cc::chardefs::asterisk &&
+                                                           end[-1] == cc::chardefs::forward_slash);
+
+            consume_run(static_cast<std::size_t>(end - cursor()));
+            return is_closed ? comment::skipped : comment::unterminated;
+        }
+    default:
+        return comment::none;
+    }
+}
+
+void cc::lexer::skip_space()
+{
+    index_ = static_cast<std::size_t>(cc::scan::skip_whitespace(cursor(), source_end()) - source_.data());
 }
 
 cc::token cc::lexer::read_integer()
 {
-    while (std::isdigit(current()))
+    while (cc::scan::is_digit(current()))
     {
         consume();
     }
@@ -298,12 +565,12 @@ cc::token cc::lexer::read_integer()
         break;
     }
 
-    return create_token(cc::token_type::integer_literal);
+    return create_numeric_token(cc::token_type::integer_literal);
 }
 
 cc::token cc::lexer::read_double()
 {
-    while (std::isdigit(current()))
+    while (cc::scan::is_digit(current()))
     {
         consume();
     }
@@ -332,14 +599,14 @@ cc::token cc::lexer::read_double()
         break;
     }
 
-    return create_token(cc::token_type::double_literal);
+    return create_numeric_token(cc::token_type::double_literal);
 }
 
 cc::token cc::lexer::read_float()
 {
     // This method is only called when current() == 'f',
     // at which point the float token is complete.
-    return create_token(cc::token_type::float_literal);
+    return create_numeric_token(cc::token_type::float_literal);
 }
 
 cc::token cc::lexer::read_exponent()
@@ -351,7 +618,7 @@ cc::token cc::lexer::read_exponent()
     }
 
     std::size_t exponent_length = 0;
-    while (std::isdigit(current()))
+    while (cc::scan::is_digit(current()))
     {
         exponent_length++;
         consume();
@@ -370,52 +637,19 @@ cc::token cc::lexer::read_exponent()
         return read_float();
     }
 
-    return create_token(cc::token_type::double_literal);
+    return create_numeric_token(cc::token_type::double_literal);
 }
 
 cc::token cc::lexer::read_unknown()
 {
-    while (!std::isspace(current()) && current() != cc::chardefs::eof)
+    while (!cc::scan::is_space(current()) && current() != cc::chardefs::eof)
     {
         consume();
     }
     return create_token(cc::token_type::unknown);
 }
 
-// TODO: Is there a better place to put this?
-
-// clang-format off
-static const std::unordered_map<std::string_view, cc::token_type> keyword_types =
-{
-    { cc::keyworddefs::char_keyword,     cc::token_type::char_keyword     },
-    { cc::keyworddefs::int_keyword,      cc::token_type::int_keyword      },
-    { cc::keyworddefs::double_keyword,   cc::token_type::double_keyword   },
-    { cc::keyworddefs::float_keyword,    cc::token_type::float_keyword    },
-    { cc::keyworddefs::struct_keyword,   cc::token_type::struct_keyword   },
-    { cc::keyworddefs::enum_keyword,     cc::token_type::enum_keyword     },
-    { cc::keyworddefs::void_keyword,     cc::token_type::void_keyword     },
-    { cc::keyworddefs::short_keyword,    cc::token_type::short_keyword    },
-    { cc::keyworddefs::long_keyword,     cc::token_type::long_keyword     },
-    { cc::keyworddefs::const_keyword,    cc::token_type::const_keyword    },
-    { cc::keyworddefs::static_keyword,   cc::token_type::static_keyword   },
-    { cc::keyworddefs::if_keyword,       cc::token_type::if_keyword       },
-    { cc::keyworddefs::else_keyword,     cc::token_type::else_keyword     },
-    { cc::keyworddefs::for_keyword,      cc::token_type::for_keyword      },
-    { cc::keyworddefs::while_keyword,    cc::token_type::while_keyword    },
-    { cc::keyworddefs::break_keyword,    cc::token_type::break_keyword    },
-    { cc::keyworddefs::continue_keyword, cc::token_type::continue_keyword },
-    { cc::keyworddefs::return_keyword,   cc::token_type::return_keyword   },
-};
-// clang-format on
-
 cc::token_type cc::lexer::get_keyword_type() const
 {
-    const std::string text = buffer_.str();
-
-    if (const auto it = keyword_types.find(text); it != keyword_types.end())
-    {
-        return it->second;
-    }
-
-    return cc::token_type::unknown;
+    return cc::keyword_type(token_text());
 }
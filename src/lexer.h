@@ -2,29 +2,139 @@
 #define C_COMPILER_LEXER_H
 
 #include "definitions.h"
+#include "identifier_table.h"
+#include "source_manager.h"
 #include "token.h"
+#include "token_buffer.h"
 #include "token_type.h"
 
-#include <sstream>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 namespace cc {
 
+enum class lexer_engine
+{
+    // Driven by the compile-time tables in lexer_tables.h
+    table_driven,
+    // Recursive character matching. Kept as the reference the table-driven engine is checked against
+    hand_written,
+};
+
 class lexer
 {
 public:
-    explicit lexer(std::string_view text)
-        : source_(text)
+    /**
+     * @brief Creates a lexer for a file registered with the `source_manager`.
+     */
+    explicit lexer(cc::file_id file, cc::lexer_engine engine = cc::lexer_engine::table_driven)
+        : engine_(engine)
+        , identifiers_(&cc::identifier_table::instance())
+        , source_(cc::source_manager::instance().file(file).text())
+        , file_(file)
         , index_(0)
-        , line_(1)
-        , column_(1)
-        , start_column_(column_)
+        , token_start_(0)
+        , is_decoding_(false)
+        , lookahead_start_(0)
+        , lookahead_count_(0)
+    {
+    }
+
+    /**
+     * @brief Creates a lexer for the byte range [`begin`, `end`) of a registered file. Token offsets
+     *        stay relative to the start of the file, so the tokens of adjacent ranges can be
+     *        concatenated. The range must start and end on token boundaries.
+     *
+     *        Identifiers are interned into `identifiers`, which lets lexers that run concurrently
+     *        each use a table of their own.
+     */
+    lexer(cc::file_id file,
+          std::size_t begin,
+          std::size_t end,
+          cc::lexer_engine engine = cc::lexer_engine::table_driven,
+          cc::identifier_table &identifiers = cc::identifier_table::instance())
+        : engine_(engine)
+        , identifiers_(&identifiers)
+        , source_(cc::source_manager::instance().file(file).text().substr(0, end))
+        , file_(file)
+        , index_(begin)
+        , token_start_(begin)
+        , is_decoding_(false)
+        , lookahead_start_(0)
+        , lookahead_count_(0)
+    {
+    }
+
+    /**
+     * @brief Creates a lexer for a buffer that is not backed by a file. The buffer is registered
+     *        with the `source_manager` under a placeholder name until the lexer is destroyed. The
+     *        positions of its tokens can only be resolved while the lexer lives; resolving one
+     *        afterwards throws `std::out_of_range`.
+     */
+    explicit lexer(std::string_view text, cc::lexer_engine engine = cc::lexer_engine::table_driven)
+        : lexer(cc::scoped_file("<input>", text), engine)
     {
     }
 
+    /**
+     * @brief  The number of tokens that can be looked at ahead of the current position.
+     */
+    static constexpr std::size_t max_lookahead = 4;
+
+    /**
+     * @brief  Lexes and consumes the next token. Only a bounded window of tokens is ever buffered, so
+     *         a source of any size can be processed in constant memory. Once the end of the source
+     *         has been reached, every call returns an `eof` token.
+     *
+     * @return The next token.
+     */
+    cc::token next();
+
+    /**
+     * @brief  Returns a token ahead of the current position without consuming it. The returned
+     *         reference is invalidated by the next call to `next()`.
+     *
+     * @param[in] lookahead How many tokens to look past the next one. Must be less than
+     *                      `max_lookahead`.
+     * @return              The token that `next()` would return after `lookahead` more calls.
+     */
+    const cc::token &peek(std::size_t lookahead = 0);
+
+    /**
+     * @brief  Lexes the whole source buffer.
+     *
+     * @return The tokens in the source buffer, terminated by an `eof` token. Token text refers to
+     *         either the source buffer or literal storage owned by this lexer, so both must outlive
+     *         the returned tokens.
+     */
     std::vector<cc::token> lex_contents();
 
+    /**
+     * @brief  Lexes the whole source buffer into structure-of-arrays storage.
+     *
+     * @return The tokens in the source buffer, terminated by an `eof` token. Decoded literals refer
+     *         to storage owned by this lexer, so it must outlive the returned buffer.
+     */
+    cc::token_buffer lex_buffer();
+
+    cc::file_id file() const
+    {
+        return file_;
+    }
+
 private:
+    lexer(cc::scoped_file file, cc::lexer_engine engine)
+        : lexer(file.id(), engine)
+    {
+        owned_file_ = std::move(file);
+    }
+
     char current() const
     {
         if (index_ >= source_.size())
@@ -37,30 +147,103 @@ private:
     void advance()
     {
         index_++;
-        column_++;
     }
 
+    /**
+     * @brief Makes the current char part of the token text.
+     */
     void consume()
     {
-        buffer_ << current();
+        if (is_decoding_)
+        {
+            literals_.back().push_back(current());
+        }
         advance();
     }
 
-    void handle_newline()
+    /**
+     * @brief Makes the next `length` chars part of the token text.
+     */
+    void consume_run(std::size_t length)
     {
+        if (is_decoding_)
+        {
+            literals_.back().append(source_.substr(index_, length));
+        }
+        index_ += length;
+    }
+
+    /**
+     * @brief Skips the current char without making it part of the token text.
+     */
+    void discard()
+    {
+        begin_decoding();
         advance();
-        line_++;
-        column_ = 1;
+    }
+
+    /**
+     * @brief Switches the current token to owned storage. Needed once the token text stops being a
+     *        contiguous range of the source, e.g. when an escaped newline is removed from a string.
+     */
+    void begin_decoding()
+    {
+        if (!is_decoding_)
+        {
+            literals_.emplace_back(token_text());
+            is_decoding_ = true;
+        }
+    }
+
+    void begin_token()
+    {
+        token_start_ = index_;
+    }
+
+    const char *cursor() const
+    {
+        return source_.data() + index_;
+    }
+
+    const char *source_end() const
+    {
+        return source_.data() + source_.size();
+    }
+
+    std::string_view token_text() const
+    {
+        return source_.substr(token_start_, index_ - token_start_);
     }
 
     void skip_space();
 
-    // TODO: Read line comment
-    // TODO: Read multiline comment
+    enum class comment
+    {
+        none,
+        skipped,
+        unterminated,
+    };
+
+    /**
+     * @brief  Skips the comment that starts at the cursor, if there is one. No token is created for
+     *         a comment.
+     *
+     * @return `none` if the cursor is not at the start of a comment. `skipped` if a comment was
+     *         skipped. `unterminated` if a block comment runs to the end of the source, in which
+     *         case it has been consumed as the text of the current token.
+     */
+    comment skip_comment();
+
     // TODO: Read char literal
+    cc::token lex_token()
+    {
+        return engine_ == cc::lexer_engine::table_driven ? next_table_driven_token() : next_token();
+    }
+
     cc::token next_token();
+    cc::token next_table_driven_token();
     cc::token read_string();
-    cc::token read_escaped();
+    void read_escaped();
     cc::token read_identifier();
     cc::token read_integer();
     cc::token read_double();
@@ -72,25 +255,49 @@ private:
 
     cc::token create_token(cc::token_type type)
     {
-        const std::string text = buffer_.str();
-        buffer_.str(std::string());
-        buffer_.clear();
+        const std::string_view text = is_decoding_ ? std::string_view(literals_.back()) : token_text();
+        is_decoding_ = false;
         return {
-            .type = type,
-            .text = text,
-            .pos  = {line_, start_column_},
+            .type     = type,
+            .text     = text,
+            .location = {static_cast<std::uint32_t>(token_start_), file_},
         };
     }
 
+    /**
+     * @brief  Creates an integer, double or float literal token and decodes its value. Literals
+     *         whose value is out of range become `unknown` tokens.
+     */
+    cc::token create_numeric_token(cc::token_type type);
+
+    cc::token create_identifier_token()
+    {
+        auto token = create_token(cc::token_type::identifier);
+        token.identifier = identifiers_->intern(token.text);
+        return token;
+    }
+
 private:
-    std::ostringstream buffer_;
+    cc::lexer_engine engine_;
+    cc::identifier_table *identifiers_;
+
+    // Owned text of literals that could not refer to the source directly. A deque never relocates
+    // its elements, so views into them stay valid as more literals are added.
+    std::deque<std::string> literals_;
+
+    // Set only for a buffer that the lexer registered itself
+    cc::scoped_file owned_file_;
 
-    // TODO: Should this be an std::string instead?
     std::string_view source_;
+    cc::file_id file_;
     std::size_t index_;
-    std::size_t line_;
-    std::size_t column_;
-    std::size_t start_column_;
+    std::size_t token_start_;
+    bool is_decoding_;
+
+    // Ring buffer of tokens that have been peeked at but not consumed yet
+    std::array<cc::token, max_lookahead> lookahead_;
+    std::size_t lookahead_start_;
+    std::size_t lookahead_count_;
 };
 
 } // namespace cc
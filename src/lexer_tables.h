@@ -0,0 +1,232 @@
+#ifndef C_COMPILER_LEXER_TABLES_H
+#define C_COMPILER_LEXER_TABLES_H
+
+#include "definitions.h"
+#include "token_type.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <utility>
+
+// Tables for the table-driven lexer engine. Everything here is generated at compile time from the
+// char and token definitions, so the engine itself is a loop of two table lookups per char.
+
+namespace cc::lexer_tables {
+
+enum class char_class : std::uint8_t
+{
+    other = 0,
+    space,
+    letter,
+    letter_e,
+    letter_f,
+    digit,
+    period,
+    sign,
+    quote,
+    punctuator,
+    eof,
+    count
+};
+
+enum class state : std::uint8_t
+{
+    start = 0,
+    identifier,
+    integer,
+    fraction,
+    exponent,
+    exponent_sign,
+    exponent_digits,
+    float_suffix,
+    punctuator,
+    unknown,
+
+    // Reached directly from `start`. These hand the token over to the shared routines of the lexer
+    whitespace,
+    string,
+    eof,
+
+    stop,
+    count
+};
+
+inline constexpr std::size_t char_class_count = static_cast<std::size_t>(char_class::count);
+inline constexpr std::size_t state_count = static_cast<std::size_t>(state::count);
+
+// Punctuators that always form a token on their own
+inline constexpr std::array<std::pair<char, cc::token_type>, 15> punctuators = {{
+    {cc::chardefs::plus,          cc::token_type::plus             },
+    {cc::chardefs::dash,          cc::token_type::minus            },
+    {cc::chardefs::asterisk,      cc::token_type::asterisk         },
+    {cc::chardefs::forward_slash, cc::token_type::forward_slash    },
+    {cc::chardefs::equal,         cc::token_type::assign           },
+    {cc::chardefs::open_paren,    cc::token_type::open_parenthesis },
+    {cc::chardefs::close_paren,   cc::token_type::close_parenthesis},
+    {cc::chardefs::open_brace,    cc::token_type::open_brace       },
+    {cc::chardefs::close_brace,   cc::token_type::close_brace      },
+    {cc::chardefs::open_angle,    cc::token_type::open_angle       },
+    {cc::chardefs::close_angle,   cc::token_type::close_angle      },
+    {cc::chardefs::open_square,   cc::token_type::open_square      },
+    {cc::chardefs::close_square,  cc::token_type::close_square     },
+    {cc::chardefs::comma,         cc::token_type::comma            },
+    {cc::chardefs::semicolon,     cc::token_type::semicolon        },
+}};
+
+constexpr std::size_t index_of(char c)
+{
+    return static_cast<unsigned char>(c);
+}
+
+constexpr std::size_t index_of(char_class c)
+{
+    return static_cast<std::size_t>(c);
+}
+
+constexpr std::size_t index_of(state s)
+{
+    return static_cast<std::size_t>(s);
+}
+
+inline constexpr auto char_classes = [] {
+    std::array<char_class, 256> classes{};
+
+    for (char c = 'a'; c <= 'z'; c++)
+    {
+        classes[index_of(c)] = char_class::letter;
+        classes[index_of(static_cast<char>(c - 'a' + 'A'))] = char_class::letter;
+    }
+    classes[index_of(cc::chardefs::underscore)] = char_class::letter;
+    classes[index_of('e')] = char_class::letter_e;
+    classes[index_of('f')] = char_class::letter_f;
+
+    for (char c = '0'; c <= '9'; c++)
+    {
+        classes[index_of(c)] = char_class::digit;
+    }
+
+    for (const char c : {' ', '\t', '\v', '\f', cc::chardefs::cr, cc::chardefs::lf})
+    {
+        classes[index_of(c)] = char_class::space;
+    }
+
+    for (const auto &[c, _] : punctuators)
+    {
+        classes[index_of(c)] = char_class::punctuator;
+    }
+
+    // Both signs are also punctuators on their own, which the `start` state accounts for
+    classes[index_of(cc::chardefs::plus)] = char_class::sign;
+    classes[index_of(cc::chardefs::dash)] = char_class::sign;
+
+    classes[index_of(cc::chardefs::period)] = char_class::period;
+    classes[index_of(cc::chardefs::quote)] = char_class::quote;
+    classes[index_of(cc::chardefs::eof)] = char_class::eof;
+
+    return classes;
+}();
+
+inline constexpr auto punctuator_types = [] {
+    std::array<cc::token_type, 256> types{};
+    types.fill(cc::token_type::unknown);
+
+    for (const auto &[c, type] : punctuators)
+    {
+        types[index_of(c)] = type;
+    }
+
+    return types;
+}();
+
+using transition_table = std::array<std::array<state, char_class_count>, state_count>;
+
+/**
+ * @brief Transitions consume the char they are taken on. A transition to `stop` ends the token
+ *        without consuming the char.
+ */
+inline constexpr transition_table transitions = [] {
+    transition_table table{};
+
+    for (auto &row : table)
+    {
+        row.fill(state::stop);
+    }
+
+    const auto set = [&table](state from, std::initializer_list<char_class> on, state to) {
+        for (const auto c : on)
+        {
+            table[index_of(from)][index_of(c)] = to;
+        }
+    };
+
+    const auto set_all_except = [&table](state from, std::initializer_list<char_class> except, state to) {
+        for (auto &next : table[index_of(from)])
+        {
+            next = to;
+        }
+        for (const auto c : except)
+        {
+            table[index_of(from)][index_of(c)] = state::stop;
+        }
+    };
+
+    using enum char_class;
+
+    set(state::start, {letter, letter_e, letter_f}, state::identifier);
+    set(state::start, {digit}, state::integer);
+    set(state::start, {sign, punctuator}, state::punctuator);
+    set(state::start, {other, period}, state::unknown);
+    set(state::start, {space}, state::whitespace);
+    set(state::start, {quote}, state::string);
+    set(state::start, {eof}, state::eof);
+
+    set(state::identifier, {letter, letter_e, letter_f, digit}, state::identifier);
+
+    set(state::integer, {digit}, state::integer);
+    set(state::integer, {period}, state::fraction);
+    set(state::integer, {letter_e}, state::exponent);
+
+    set(state::fraction, {digit}, state::fraction);
+    set(state::fraction, {period}, state::unknown);
+    set(state::fraction, {letter_e}, state::exponent);
+    set(state::fraction, {letter_f}, state::float_suffix);
+
+    // An exponent must have at least one digit, otherwise the rest of the word is unknown
+    set_all_except(state::exponent, {space, eof}, state::unknown);
+    set(state::exponent, {sign}, state::exponent_sign);
+    set(state::exponent, {digit}, state::exponent_digits);
+
+    set_all_except(state::exponent_sign, {space, eof}, state::unknown);
+    set(state::exponent_sign, {digit}, state::exponent_digits);
+
+    set(state::exponent_digits, {digit}, state::exponent_digits);
+    set(state::exponent_digits, {letter_f}, state::float_suffix);
+
+    set_all_except(state::unknown, {space, eof}, state::unknown);
+
+    return table;
+}();
+
+/**
+ * @brief The type of the token that ends in each state. Identifiers and punctuators are refined
+ *        further using the keyword and punctuator tables.
+ */
+inline constexpr auto accepted_types = [] {
+    std::array<cc::token_type, state_count> types{};
+    types.fill(cc::token_type::unknown);
+
+    types[index_of(state::identifier)] = cc::token_type::identifier;
+    types[index_of(state::integer)] = cc::token_type::integer_literal;
+    types[index_of(state::fraction)] = cc::token_type::double_literal;
+    types[index_of(state::exponent_digits)] = cc::token_type::double_literal;
+    types[index_of(state::float_suffix)] = cc::token_type::float_literal;
+    types[index_of(state::eof)] = cc::token_type::eof;
+
+    return types;
+}();
+
+} // namespace cc::lexer_tables
+
+#endif
@@ -1,30 +1,56 @@
+#include "diagnostics.h"
+#include "file_buffer.h"
+#include "flat_ast.h"
 #include "lexer.h"
+#include "parallel_lexer.h"
 #include "parser.h"
+#include "serialized_ast.h"
+#include "token_buffer.h"
 
 #include <algorithm>
 #include <cctype>
+#include <charconv>
 #include <cstdlib>
 #include <fstream>
 #include <iomanip>
+#include <optional>
+#include <string_view>
+#include <system_error>
 
 constexpr int position_column_width = 8;
 constexpr int type_column_width = 5;
 constexpr int text_column_width = 20;
 
+struct options
+{
+    std::string file_name;
+
+    // The number of threads to lex and parse on. Both are serial unless this is greater than 1.
+    std::size_t jobs = 1;
+
+    // Where to write the syntax tree in the format of `cc::serialized_ast`, if anywhere
+    std::string ast_file_name;
+};
+
 // TODO: Clean up interactive console vs cmdline exec selection
 // TODO: Remove code duplication between run and run_debug
-void run(const std::string &file_name);
+std::optional<options> parse_options(int argc, char **argv);
+void run(const options &opts);
 void run_debug();
+void print_tokens(const cc::token_buffer &tokens);
+void print_diagnostics(const cc::diagnostics &diagnostics);
+void write_ast(const cc::syntax_node &root, const std::string &file_name);
 
 int main(int argc, char **argv)
 {
 #ifdef NDEBUG
-    if (argc < 2)
+    const auto opts = parse_options(argc, argv);
+    if (!opts)
     {
-        std::cerr << "No input file provided\n";
+        std::cerr << "Usage: compiler [-j <threads>] [--emit-ast <output>] <file>\n";
         return EXIT_FAILURE;
     }
-    run(argv[1]);
+    run(*opts);
 #else
     run_debug();
 #endif
@@ -43,91 +69,154 @@ void run_debug()
             break;
         }
 
-        auto lexer = cc::lexer(source);
-        auto tokens = lexer.lex_contents();
-        std::cout << "== TOKENS ==" << "\n\n";
-        for (const auto &token : tokens)
+        // Released at the end of the iteration, along with the line it refers to
+        const auto source_file = cc::scoped_file("<stdin>", source);
+
+        auto lexer = cc::lexer(source_file.id());
+        const auto tokens = lexer.lex_buffer();
+        print_tokens(tokens);
+
+        auto par = cc::parser(tokens);
+        const std::shared_ptr<cc::syntax_node> root = par.parse_contents();
+
+        if (!par.diagnostics().empty())
         {
-            std::cout << std::left << std::setw(position_column_width) << token.pos.to_string()
-                                   << std::setw(type_column_width)     << token.type
-                                   << std::setw(text_column_width)     << token.text << '\n';
+            print_diagnostics(par.diagnostics());
+            continue;
         }
+
+        std::cout << "== AST ==" << "\n\n";
+        root->print_tree(std::cout);
         std::cout << '\n';
+    }
+}
 
-        auto par = cc::parser(tokens);
+std::optional<options> parse_options(int argc, char **argv)
+{
+    options opts;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const auto arg = std::string_view(argv[i]);
 
-        std::shared_ptr<cc::syntax_node> root;
-        try
+        if (arg == "-j")
         {
-            root = par.parse_contents();
+            if (++i == argc)
+            {
+                return std::nullopt;
+            }
+
+            const auto value = std::string_view(argv[i]);
+            const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), opts.jobs);
+            if (error != std::errc() || end != value.data() + value.size() || opts.jobs == 0)
+            {
+                return std::nullopt;
+            }
         }
-        catch (const std::exception &ex)
+        else if (arg == "--emit-ast")
         {
-            std::cout << "Error: " << ex.what() << '\n';
-            continue;
+            if (++i == argc)
+            {
+                return std::nullopt;
+            }
+
+            opts.ast_file_name = argv[i];
+        }
+        else if (opts.file_name.empty())
+        {
+            opts.file_name = arg;
         }
+        else
+        {
+            return std::nullopt;
+        }
+    }
 
-        std::cout << "== AST ==" << "\n\n";
-        std::cout << root->tree_representation();
-        std::cout << '\n';
+    if (opts.file_name.empty())
+    {
+        return std::nullopt;
     }
+
+    return opts;
 }
 
-void run(const std::string &file_name)
+void run(const options &opts)
 {
-    auto in = std::ifstream(file_name, std::ios::binary | std::ios::ate);
+    const auto &file_name = opts.file_name;
+    std::optional<cc::file_buffer> file;
 
-    if (!in)
+    try
+    {
+        // Map the file rather than copying it. The lexer works on a string_view, so the mapping is
+        // handed to it as-is.
+        file.emplace(file_name);
+    }
+    catch (const std::system_error &)
     {
         std::cout << "Invalid filename " << std::quoted(file_name) << '\n';
         return;
     }
 
-    // Get char count of file. Note that istream::tellg() has_return an std::streampos which is not
-    // guaranteed to be the same size as std::size_t (e.g. in the case that the file is greater than
-    // 4 GB on a 32-bit system). We will assume that no source files being read exceed this value.
+    const auto source_file = cc::source_manager::instance().add_file(file_name, file->contents());
 
-    // Get start and end positions
-    const auto end = in.tellg();
-    in.seekg(0, std::ios::beg);
-    const auto start = in.tellg();
+    // Lex once into compact storage; both the dump and the parser read from the same buffer. The
+    // lexers own decoded literals, so they stay alive for as long as the tokens do.
+    std::optional<cc::lexer> lexer;
+    std::optional<cc::parallel_lexer> parallel_lexer;
+    const auto tokens = opts.jobs > 1 ? parallel_lexer.emplace(source_file, opts.jobs).lex_buffer()
+                                      : lexer.emplace(source_file).lex_buffer();
+    print_tokens(tokens);
 
-    const auto size = static_cast<std::size_t>(end - start);
+    auto parser = cc::parser(tokens);
+    const auto root = parser.parse_contents(opts.jobs);
 
-    // Construct a string with this size
-    std::string source;
-    source.resize(size);
+    if (!parser.diagnostics().empty())
+    {
+        print_diagnostics(parser.diagnostics());
+        return;
+    }
 
-    // Read file stream into source string
-    in.read(source.data(), static_cast<std::streamsize>(size));
-    in.close();
+    std::cout << "== AST ==" << "\n\n";
+    root->print_tree(std::cout);
+    std::cout << '\n';
+    std::cout << '\n';
 
-    auto lexer = cc::lexer(source);
-    auto tokens = lexer.lex_contents();
+    if (!opts.ast_file_name.empty())
+    {
+        write_ast(*root, opts.ast_file_name);
+    }
+}
 
+void print_tokens(const cc::token_buffer &tokens)
+{
     std::cout << "== TOKENS ==" << "\n\n";
     for (const auto &token : tokens)
     {
-        std::cout << std::left << std::setw(position_column_width) << token.pos.to_string()
+        std::cout << std::left << std::setw(position_column_width) << token.position().to_string()
                                << std::setw(type_column_width)     << token.type
                                << std::setw(text_column_width)     << token.text << '\n';
     }
     std::cout << '\n';
+}
 
-    auto parser = cc::parser(tokens);
-
-    std::unique_ptr<cc::syntax_node> root;
-    try
+void print_diagnostics(const cc::diagnostics &diagnostics)
+{
+    for (const auto &diagnostic : diagnostics)
     {
-        root = parser.parse_contents();
+        std::cout << diagnostic.to_string() << '\n';
     }
-    catch (const std::exception &ex)
+    std::cout << diagnostics.size() << (diagnostics.size() == 1 ? " error" : " errors") << " generated\n";
+}
+
+void write_ast(const cc::syntax_node &root, const std::string &file_name)
+{
+    const auto bytes = cc::serialize(cc::to_flat_ast(root));
+
+    auto out = std::ofstream(file_name, std::ios::binary);
+    out.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+
+    if (!out)
     {
-        std::cout << "Error: " << ex.what() << '\n';
-        return;
+        std::cout << "Cannot write " << std::quoted(file_name) << '\n';
     }
-
-    std::cout << "== AST ==" << "\n\n";
-    std::cout << root->tree_representation() << '\n';
-    std::cout << '\n';
 }
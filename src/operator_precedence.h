@@ -0,0 +1,88 @@
+#ifndef C_COMPILER_OPERATOR_PRECEDENCE_H
+#define C_COMPILER_OPERATOR_PRECEDENCE_H
+
+#include "token_type.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+namespace cc {
+
+/**
+ * @brief How tightly a binary operator binds, from loosest to tightest, as in the C grammar. The
+ *        conditional operator would sit between `assignment` and `logical_or`.
+ */
+enum class precedence : std::uint8_t
+{
+    // Not a binary operator
+    none = 0,
+
+    comma,
+    assignment,
+    logical_or,
+    logical_and,
+    bitwise_or,
+    bitwise_xor,
+    bitwise_and,
+    equality,
+    relational,
+    shift,
+    additive,
+    multiplicative,
+};
+
+inline constexpr std::size_t token_type_count = static_cast<std::size_t>(cc::token_type::unknown) + 1;
+
+/**
+ * @brief The precedence of every token type when it appears between two operands.
+ */
+inline constexpr auto binary_precedences = [] {
+    std::array<cc::precedence, token_type_count> table{};
+
+    const auto set = [&table](std::initializer_list<cc::token_type> types, cc::precedence level) {
+        for (const auto type : types)
+        {
+            table[static_cast<std::size_t>(type)] = level;
+        }
+    };
+
+    using enum cc::token_type;
+
+    set({comma}, precedence::comma);
+    set({assign, plus_assign, minus_assign, times_assign, divide_assign, mod_assign}, precedence::assignment);
+    set({logical_or}, precedence::logical_or);
+    set({logical_and}, precedence::logical_and);
+    set({bitwise_or}, precedence::bitwise_or);
+    set({bitwise_xor}, precedence::bitwise_xor);
+    set({bitwise_and}, precedence::bitwise_and);
+    set({comparison_equals, comparison_not_equals}, precedence::equality);
+
+    // The lexer produces angle brackets for '<' and '>'
+    set({less_than, greater_than, open_angle, close_angle}, precedence::relational);
+
+    set({left_shift, right_shift}, precedence::shift);
+    set({plus, minus}, precedence::additive);
+    set({asterisk, forward_slash, mod}, precedence::multiplicative);
+
+    return table;
+}();
+
+constexpr cc::precedence binary_precedence(cc::token_type type)
+{
+    return binary_precedences[static_cast<std::size_t>(type)];
+}
+
+/**
+ * @brief  Whether operators of the same precedence group from the right, so that `a = b = c` is
+ *         `a = (b = c)`. All other binary operators group from the left.
+ */
+constexpr bool is_right_associative(cc::precedence level)
+{
+    return level == cc::precedence::assignment;
+}
+
+} // namespace cc
+
+#endif
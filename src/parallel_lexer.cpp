@@ -0,0 +1,176 @@
+#include "parallel_lexer.h"
+
+#include "definitions.h"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <optional>
+
+namespace {
+
+// An LF is a token boundary unless a backslash continues the line across it, as it does inside
+// string literals and line comments, or it is inside a block comment. Anything else that reaches an
+// LF (identifiers, numbers, unterminated strings, unknown tokens) ends there.
+//
+// Block comments cannot be ruled out without lexing everything before the LF, so they are dealt
+// with after the fact: see lex_buffer().
+bool is_safe_split(std::string_view text, std::size_t newline)
+{
+    std::size_t previous = newline;
+
+    if (previous > 0 && text[previous - 1] == cc::chardefs::cr)
+    {
+        previous--;
+    }
+
+    return previous == 0 || text[previous - 1] != cc::chardefs::backslash;
+}
+
+std::size_t find_split(std::string_view text, std::size_t from)
+{
+    while (from < text.size())
+    {
+        const auto *newline = static_cast<const char *>(std::memchr(text.data() + from, cc::chardefs::lf, text.size() - from));
+
+        if (!newline)
+        {
+            break;
+        }
+
+        const auto offset = static_cast<std::size_t>(newline - text.data());
+        if (is_safe_split(text, offset))
+        {
+            return offset + 1;
+        }
+
+        from = offset + 1;
+    }
+
+    return text.size();
+}
+
+} // namespace
+
+std::vector<std::size_t> cc::parallel_lexer::split(std::string_view text, std::size_t chunk_count, std::size_t min_chunk_size)
+{
+    chunk_count = std::clamp<std::size_t>(text.size() / std::max<std::size_t>(min_chunk_size, 1), 1, std::max<std::size_t>(chunk_count, 1));
+
+    std::vector<std::size_t> boundaries = {0};
+
+    for (std::size_t i = 1; i < chunk_count; i++)
+    {
+        const auto target = std::max(text.size() / chunk_count * i, boundaries.back());
+        const auto boundary = find_split(text, target);
+
+        if (boundary >= text.size())
+        {
+            break;
+        }
+
+        if (boundary > boundaries.back())
+        {
+            boundaries.push_back(boundary);
+        }
+    }
+
+    boundaries.push_back(text.size());
+    return boundaries;
+}
+
+cc::token_buffer cc::parallel_lexer::lex_buffer()
+{
+    const auto boundaries = split(cc::source_manager::instance().file(file_).text(), thread_count_, min_chunk_size_);
+    const auto chunk_count = boundaries.size() - 1;
+
+    // The global identifier table is not thread-safe, so every chunk interns into a table of its
+    // own. The tables are merged into the global one afterwards.
+    std::deque<cc::identifier_table> identifier_tables(chunk_count);
+
+    for (std::size_t i = 0; i < chunk_count; i++)
+    {
+        lexers_.emplace_back(file_, boundaries[i], boundaries[i + 1], engine_, identifier_tables[i]);
+    }
+
+    // The first chunk is lexed on the calling thread while the others run in the background
+    std::vector<std::future<cc::token_buffer>> pending;
+    pending.reserve(chunk_count - 1);
+    for (std::size_t i = 1; i < chunk_count; i++)
+    {
+        pending.push_back(std::async(std::launch::async, [&lexer = lexers_[i]] { return lexer.lex_buffer(); }));
+    }
+
+    std::vector<cc::token_buffer> chunks;
+    chunks.reserve(chunk_count);
+    chunks.push_back(lexers_.front().lex_buffer());
+    for (auto &future : pending)
+    {
+        chunks.push_back(future.get());
+    }
+
+    std::size_t total_size = 0;
+    for (const auto &chunk : chunks)
+    {
+        total_size += chunk.size();
+    }
+
+    auto tokens = cc::token_buffer(file_);
+    tokens.reserve(total_size);
+
+    auto &global_identifiers = cc::identifier_table::instance();
+    std::vector<cc::identifier_id> identifier_map;
+    std::optional<std::uint32_t> open_comment;
+
+    for (std::size_t i = 0; i < chunk_count; i++)
+    {
+        auto &chunk = chunks[i];
+        const auto *local_table = &identifier_tables[i];
+
+        // If the previous chunk ended inside a block comment, this chunk was lexed from the middle
+        // of that comment and its tokens are meaningless. Lex it again from the start of the
+        // comment instead, with a fresh identifier table so that no bogus identifiers leak into the
+        // global one.
+        if (open_comment)
+        {
+            local_table = &identifier_tables.emplace_back();
+            chunk = lexers_.emplace_back(file_, *open_comment, boundaries[i + 1], engine_, identifier_tables.back()).lex_buffer();
+            open_comment.reset();
+        }
+
+        // Chunks are merged in order, and each local table is in order of first use, so identifiers
+        // get the same global ids as they would from a serial lexer
+        const auto &local_identifiers = *local_table;
+        identifier_map.resize(local_identifiers.size());
+        for (cc::identifier_id id = 0; id < local_identifiers.size(); id++)
+        {
+            identifier_map[id] = global_identifiers.intern(local_identifiers.text(id));
+        }
+        chunk.remap_identifiers(identifier_map);
+
+        // Every chunk ends in an eof token. If it sits at the end of the chunk, it is an artifact of
+        // the split and is dropped, except after the last chunk. If it does not, the chunk hit a
+        // null char, which ends lexing of the whole file.
+        const bool is_end_of_file = i + 1 == chunk_count || chunk.offset(chunk.size() - 1) != boundaries[i + 1];
+
+        if (is_end_of_file)
+        {
+            tokens.append(chunk, chunk.size());
+            break;
+        }
+
+        // An unterminated block comment is lexed as an unknown token that runs to the end of the
+        // chunk. Unless this is the last chunk, the comment carries on into the next one.
+        if (const auto last = chunk.size() - 2; chunk.size() >= 2 && chunk.type(last) == cc::token_type::unknown &&
+                                                 chunk.text(last).starts_with("/*"))
+        {
+            open_comment = chunk.offset(last);
+            tokens.append(chunk, last);
+            continue;
+        }
+
+        tokens.append(chunk, chunk.size() - 1);
+    }
+
+    return tokens;
+}
@@ -0,0 +1,86 @@
+#ifndef C_COMPILER_PARALLEL_LEXER_H
+#define C_COMPILER_PARALLEL_LEXER_H
+
+#include "lexer.h"
+#include "source_manager.h"
+#include "token_buffer.h"
+
+#include <cstddef>
+#include <deque>
+#include <string_view>
+#include <vector>
+
+namespace cc {
+
+/**
+ * @brief Lexes a large file on several threads. The file is split into chunks at newlines that
+ *        cannot be inside a token, each chunk is lexed by its own `lexer`, and the results are
+ *        concatenated. A chunk that turns out to start inside a block comment is lexed again from
+ *        the start of the comment. The output is identical to that of a single `lexer` over the
+ *        whole file.
+ */
+class parallel_lexer
+{
+public:
+    /**
+     * @brief The smallest chunk worth handing to a thread of its own.
+     */
+    static constexpr std::size_t default_min_chunk_size = 64 * 1024;
+
+    /**
+     * @param[in] file           A file registered with the `source_manager`.
+     * @param[in] thread_count   The maximum number of threads to lex on, including the calling
+     *                           thread.
+     * @param[in] engine         The engine each chunk lexer uses.
+     * @param[in] min_chunk_size Files are split into fewer chunks than there are threads when the
+     *                           chunks would otherwise be smaller than this.
+     */
+    parallel_lexer(cc::file_id file,
+                   std::size_t thread_count,
+                   cc::lexer_engine engine = cc::lexer_engine::table_driven,
+                   std::size_t min_chunk_size = default_min_chunk_size)
+        : file_(file)
+        , thread_count_(thread_count)
+        , engine_(engine)
+        , min_chunk_size_(min_chunk_size)
+    {
+    }
+
+    parallel_lexer(const parallel_lexer &) = delete;
+    parallel_lexer &operator=(const parallel_lexer &) = delete;
+
+    /**
+     * @brief  Lexes the whole file.
+     *
+     * @return The tokens in the file, terminated by an `eof` token. Decoded literals refer to
+     *         storage owned by this object, so it must outlive the returned buffer.
+     */
+    cc::token_buffer lex_buffer();
+
+    /**
+     * @brief  Splits `text` into at most `chunk_count` chunks of roughly equal size. Every chunk
+     *         except the last ends just past an LF that is not part of a line continuation, which
+     *         is a token boundary unless it is inside a block comment.
+     *
+     * @param[in] text           The text to split.
+     * @param[in] chunk_count    The number of chunks to aim for.
+     * @param[in] min_chunk_size The size below which chunks are not split any further.
+     * @return                   The offset of the start of every chunk, followed by the size of
+     *                           `text`.
+     */
+    static std::vector<std::size_t> split(std::string_view text, std::size_t chunk_count, std::size_t min_chunk_size);
+
+private:
+    cc::file_id file_;
+    std::size_t thread_count_;
+    cc::lexer_engine engine_;
+    std::size_t min_chunk_size_;
+
+    // One lexer per chunk. They own the storage for decoded literals, so they are kept for as long
+    // as this object lives.
+    std::deque<cc::lexer> lexers_;
+};
+
+} // namespace cc
+
+#endif
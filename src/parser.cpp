@@ -2,93 +2,200 @@
 
 #include "symbol_table.h"
 #include "token.h"
+#include "token_buffer.h"
 #include "token_type.h"
-#include "syntax/binary_expression.h"
-#include "syntax/compound_statement.h"
-#include "syntax/declaration.h"
-#include "syntax/declaration_reference_expression.h"
-#include "syntax/expression.h"
-#include "syntax/function_declaration.h"
-#include "syntax/literal.h"
-#include "syntax/parenthesized_expression.h"
-#include "syntax/primary_expression.h"
-#include "syntax/return_statement.h"
-#include "syntax/statement.h"
-#include "syntax/translation_unit_declaration.h"
-#include "syntax/variable_declaration.h"
-
-std::unique_ptr<cc::primary_expression> cc::parser::parse_literal()
+#include "syntax/syntax_type.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+template<typename Builder>
+void cc::basic_parser<Builder>::refill()
 {
-    const auto &current = current_token();
+    auto &window = *window_;
 
+    // Once the eof token is in the window there is nothing left to pull
+    if (!window.empty() && window.type(window.size() - 1) == cc::token_type::eof)
+    {
+        return;
+    }
+
+    window.erase_front(index_);
+    index_ = 0;
+
+    while (window.size() < window_size)
+    {
+        const auto token = lexer_->next();
+        window.push_back(token);
+
+        if (token.type == cc::token_type::eof)
+        {
+            break;
+        }
+    }
+}
+
+template<typename Builder>
+void cc::basic_parser<Builder>::synchronize()
+{
+    std::size_t depth = 0;
+
+    while (!match(cc::token_type::eof))
+    {
+        const auto type = current_type();
+
+        if (type == cc::token_type::close_brace && depth == 0)
+        {
+            // A stray '}' outside of any block has to be skipped, or parsing would never move on
+            if (symbols_.depth() == 0)
+            {
+                advance();
+            }
+            break;
+        }
+
+        advance();
+
+        if (type == cc::token_type::open_brace)
+        {
+            depth++;
+        }
+        else if (type == cc::token_type::close_brace && --depth == 0)
+        {
+            break;
+        }
+        else if (type == cc::token_type::semicolon && depth == 0)
+        {
+            break;
+        }
+    }
+
+    panicking_ = false;
+}
+
+template<typename Builder>
+auto cc::basic_parser<Builder>::parse_literal() -> node
+{
     if (!match(cc::token_type::char_literal,
                cc::token_type::integer_literal,
                cc::token_type::double_literal,
                cc::token_type::float_literal,
                cc::token_type::string_literal))
     {
-        throw std::runtime_error("Expected a literal");
+        return syntax_error("Expected a literal");
     }
+
+    const auto current = current_ref();
     advance();
 
-    switch (current.type)
-    {
-    case cc::token_type::char_literal:
-        return std::make_unique<cc::char_literal>(current);
-    case cc::token_type::integer_literal:
-        return std::make_unique<cc::integer_literal>(current);
-    case cc::token_type::double_literal:
-        return std::make_unique<cc::double_literal>(current);
-    case cc::token_type::float_literal:
-        return std::make_unique<cc::float_literal>(current);
-    case cc::token_type::string_literal:
-        return std::make_unique<cc::string_literal>(current);
-    default:
-        throw std::runtime_error("Hit unreachable branch in parse_literal()");
-    }
+    return builder_.literal(current);
 }
 
-std::unique_ptr<cc::parenthesized_expression> cc::parser::parse_parenthesized_expression()
+template<typename Builder>
+auto cc::basic_parser<Builder>::parse_parenthesized_expression() -> node
 {
-    const auto &start_token = current_token();
+    const auto start_token = current_ref();
 
     if (!consume(cc::token_type::open_parenthesis))
     {
-        throw std::runtime_error("Expected a '('");
+        return syntax_error("Expected a '('");
+    }
+
+    if (expression_depth_ == max_expression_depth)
+    {
+        return syntax_error("Parentheses are nested too deeply");
     }
 
-    auto expr = parse_expression();
+    expression_depth_++;
+    const auto expr = parse_expression();
+    expression_depth_--;
+
+    if (panicking_)
+    {
+        return expr;
+    }
 
     if (!consume(cc::token_type::close_parenthesis))
     {
-        throw std::runtime_error("Expected a ')'");
+        return syntax_error("Expected a ')'");
     }
 
-    return std::make_unique<cc::parenthesized_expression>(start_token, std::move(expr));
+    return builder_.parenthesized_expression(start_token, expr);
 }
 
-std::unique_ptr<cc::declaration_reference_expression> cc::parser::parse_declaration_reference_expression()
+template<typename Builder>
+auto cc::basic_parser<Builder>::parse_declaration_reference_expression() -> node
 {
-    const auto &identifier = current_token();
-
-    if (!consume(cc::token_type::identifier))
+    if (!match(cc::token_type::identifier))
     {
-        throw std::runtime_error("Expected an lvalue");
+        return syntax_error("Expected an lvalue");
     }
 
-    if (!scope_.top()->is_declared(identifier.text))
+    const auto identifier = current_ref();
+    advance();
+
+    const auto reference = builder_.declaration_reference_expression(identifier);
+    const auto symbol = symbols_.lookup(identifier.identifier());
+
+    if (!symbol)
     {
-        throw std::runtime_error("Identifier '" + identifier.text + "' is undefined");
+        report(identifier, "Identifier '" + std::string(identifier.text()) + "' is undefined");
+        return reference;
     }
 
-    return std::make_unique<cc::declaration_reference_expression>(identifier);
+    resolve(reference, identifier.identifier(), *symbol);
+    return reference;
+}
+
+template<typename Builder>
+void cc::basic_parser<Builder>::resolve(node reference, cc::identifier_id identifier, const typename symbol_table::symbol &symbol)
+{
+    if (detached_ && symbol.is_file_scope)
+    {
+        file_scope_references_.push_back({reference, identifier});
+    }
+    else if (symbol.declaration != Builder::none)
+    {
+        builder_.resolve(reference, symbol.declaration);
+    }
+    else
+    {
+        unresolved_.push_back({reference, symbol.binding});
+    }
 }
 
-std::unique_ptr<cc::primary_expression> cc::parser::parse_primary_expression()
+template<typename Builder>
+void cc::basic_parser<Builder>::declared(cc::token_ref identifier, node declaration)
 {
-    const auto &current = current_token();
+    const auto binding = symbols_.set_declaration(identifier.identifier(), declaration);
+
+    if (!binding || unresolved_.empty())
+    {
+        return;
+    }
+
+    std::erase_if(unresolved_, [&](const unresolved_reference &unresolved) {
+        if (unresolved.binding != *binding)
+        {
+            return false;
+        }
+
+        builder_.resolve(unresolved.reference, declaration);
+        return true;
+    });
+}
 
-    switch (current.type)
+template<typename Builder>
+auto cc::basic_parser<Builder>::parse_primary_expression() -> node
+{
+    switch (current_type())
     {
     case cc::token_type::open_parenthesis:
         return parse_parenthesized_expression();
@@ -107,202 +214,425 @@ std::unique_ptr<cc::primary_expression> cc::parser::parse_primary_expression()
         break;
     }
 
-    throw std::runtime_error("Expected a primary expression");
+    return syntax_error("Expected a primary expression");
 }
 
-std::unique_ptr<cc::return_statement> cc::parser::parse_return_statement()
+template<typename Builder>
+auto cc::basic_parser<Builder>::parse_return_statement() -> node
 {
-    const auto &return_token = current_token();
-
-    if (!consume(cc::token_type::return_keyword))
+    if (!match(cc::token_type::return_keyword))
     {
-        throw std::runtime_error("Expected a 'return' keyword");
+        return syntax_error("Expected a 'return' keyword");
     }
 
+    const auto return_token = current_ref();
+    advance();
+
     if (consume(cc::token_type::semicolon))
     {
-        return std::make_unique<cc::return_statement>(return_token);
+        return builder_.return_statement(return_token, Builder::none);
     }
 
-    auto return_expression = parse_expression();
+    const auto return_expression = parse_expression();
+
+    if (panicking_)
+    {
+        return return_expression;
+    }
 
     if (!consume(cc::token_type::semicolon))
     {
-        throw std::runtime_error("Expected a ';'");
+        return syntax_error("Expected a ';'");
     }
 
-    return std::make_unique<cc::return_statement>(return_token, std::move(return_expression));
+    return builder_.return_statement(return_token, return_expression);
 }
 
-std::unique_ptr<cc::compound_statement> cc::parser::parse_compound_statement()
+template<typename Builder>
+auto cc::basic_parser<Builder>::parse_compound_statement() -> node
 {
-    auto local_scope = symbol_table(scope_.top());
-    scope_.push(&local_scope);
-
-    const auto &start = current_token();
-
-    if (!consume(cc::token_type::open_brace))
+    if (!match(cc::token_type::open_brace))
     {
-        throw std::runtime_error("Expected a ';' or a '{'");
+        return syntax_error("Expected a ';' or a '{'");
     }
 
-    auto statements = std::make_unique<cc::compound_statement>(start);
+    const auto start = current_ref();
+    advance();
 
+    symbols_.enter_scope();
+
+    const auto first_child = pending_children_.size();
     bool has_return_statement = false;
 
-    while (!consume(cc::token_type::close_brace))
+    while (!match(cc::token_type::close_brace, cc::token_type::eof))
     {
-        auto stmt = parse_statement();
+        const auto stmt = parse_statement();
+
+        if (panicking_)
+        {
+            synchronize();
+        }
 
-        if (stmt->type() == cc::syntax_type::return_statement)
+        if (builder_.kind(stmt) == cc::syntax_type::return_statement)
         {
             has_return_statement = true;
         }
 
-        statements->add_statement(std::move(stmt));
+        pending_children_.push_back(stmt);
+    }
+
+    // The block is kept even if the file ends before it is closed
+    if (!consume(cc::token_type::close_brace))
+    {
+        report(current_ref(), "Expected a '}'");
     }
 
-    statements->has_return(has_return_statement);
-    scope_.pop();
+    const auto statements = builder_.compound_statement(start, children_since(first_child), has_return_statement);
+    pending_children_.resize(first_child);
+    symbols_.leave_scope();
+
+    // A declaration that failed to parse leaves its references unresolved
+    if (!unresolved_.empty())
+    {
+        std::erase_if(unresolved_, [&](const unresolved_reference &unresolved) { return unresolved.binding >= symbols_.size(); });
+    }
 
     return statements;
 }
 
-std::unique_ptr<cc::variable_declaration> cc::parser::parse_variable_declaration(const cc::token &type_specifier,
-                                                                                 const cc::token &identifier)
+template<typename Builder>
+void cc::basic_parser<Builder>::skip_block()
 {
-    if (scope_.top()->is_declared_in_scope(identifier.text))
+    // Only used on a token buffer, so the type array can be scanned directly. A block that is still
+    // open at the end of the file runs up to the eof token.
+    const auto eof = tokens_->size() - 1;
+    std::size_t depth = 0;
+
+    while (index_ < eof)
     {
-        throw std::runtime_error("Redefinition of " + identifier.text + "\nFirst declaration at ");
+        const auto type = tokens_->type(index_++);
+
+        if (type == cc::token_type::open_brace)
+        {
+            depth++;
+        }
+        else if (type == cc::token_type::close_brace && --depth == 0)
+        {
+            break;
+        }
+    }
+}
+
+template<typename Builder>
+auto cc::basic_parser<Builder>::parse_function_body() -> node
+{
+    // Only bodies at file scope are parsed out of order. Anything else, including a body that is
+    // missing its '{', is parsed in place.
+    if (body_mode_ == body_mode::parse || symbols_.depth() != 0 || !match(cc::token_type::open_brace))
+    {
+        return parse_compound_statement();
     }
 
-    scope_.top()->declare(identifier.text);
+    if (body_mode_ == body_mode::skip)
+    {
+        const auto first = index_;
+        skip_block();
+        bodies_.push_back({.first = first, .last = index_});
+
+        // Nothing looks at the tree built while skipping bodies
+        return builder_.compound_statement((*tokens_)[first], {}, true);
+    }
+
+    // Compound statements consume exactly the tokens up to their matching brace, so the bodies
+    // come up in the same order and at the same places as they were found
+    auto &body = bodies_[next_body_++];
+    index_ = body.last;
+
+    const auto &found = body.parser->diagnostics_;
+    for (auto it = found.begin() + static_cast<std::ptrdiff_t>(body.first_diagnostic);
+         it != found.begin() + static_cast<std::ptrdiff_t>(body.last_diagnostic); ++it)
+    {
+        diagnostics_.error(it->location, it->message);
+    }
+
+    const auto root = builder_.adopt(body.parser->builder_, body.root);
+
+    // The file scope is now exactly as the body saw it, so its references resolve the same way
+    const auto &references = body.parser->file_scope_references_;
+    for (auto i = body.first_reference; i != body.last_reference; i++)
+    {
+        if (const auto symbol = symbols_.lookup(references[i].identifier))
+        {
+            resolve(builder_.adopted(references[i].reference), references[i].identifier, *symbol);
+        }
+    }
+
+    return root;
+}
+
+template<typename Builder>
+void cc::basic_parser<Builder>::parse_function_bodies(std::span<function_body> bodies, const symbol_table &globals)
+{
+    symbols_ = globals;
+    detached_ = true;
+
+    for (auto &body : bodies)
+    {
+        index_ = body.first;
+        symbols_.limit_file_scope(position());
+
+        body.parser = this;
+        body.first_diagnostic = diagnostics_.size();
+        body.first_reference = file_scope_references_.size();
+        body.root = parse_compound_statement();
+        body.last_diagnostic = diagnostics_.size();
+        body.last_reference = file_scope_references_.size();
+    }
+}
+
+template<typename Builder>
+auto cc::basic_parser<Builder>::parse_variable_declaration(cc::token_ref type_specifier, cc::token_ref identifier) -> node
+{
+    if (symbols_.is_declared_in_scope(identifier.identifier()))
+    {
+        report(identifier, "Redefinition of '" + std::string(identifier.text()) + "'");
+    }
+
+    symbols_.declare(identifier.identifier(), identifier.location().offset);
 
     if (consume(cc::token_type::semicolon))
     {
-        return std::make_unique<cc::variable_declaration>(type_specifier, identifier);
+        const auto declaration = builder_.variable_declaration(type_specifier, identifier, Builder::none);
+        declared(identifier, declaration);
+        return declaration;
     }
 
     if (!consume(cc::token_type::assign))
     {
-        throw std::runtime_error("Expected a ';' or a '='");
+        return syntax_error("Expected a ';' or a '='");
     }
 
-    auto initializer = parse_expression();
+    const auto initializer = parse_expression(cc::precedence::assignment);
+
+    if (panicking_)
+    {
+        return initializer;
+    }
 
     if (!consume(cc::token_type::semicolon))
     {
-        throw std::runtime_error("Expected a ';'");
+        return syntax_error("Expected a ';'");
     }
 
-    scope_.top()->define(identifier.text, true);
+    symbols_.define(identifier.identifier(), position());
 
-    return std::make_unique<cc::variable_declaration>(
+    const auto declaration = builder_.variable_declaration(
         type_specifier,
         identifier,
-        std::move(initializer)
+        initializer
     );
+
+    declared(identifier, declaration);
+    return declaration;
 }
 
-std::unique_ptr<cc::function_declaration> cc::parser::parse_function_declaration(const cc::token &type_specifier,
-                                                                                 const cc::token &identifier)
+template<typename Builder>
+auto cc::basic_parser<Builder>::parse_function_declaration(cc::token_ref type_specifier, cc::token_ref identifier) -> node
 {
     if (!consume(cc::token_type::open_parenthesis))
     {
-        throw std::runtime_error("Expected a '('");
+        return syntax_error("Expected a '('");
     }
 
     // TODO: Parse parameter declarations
 
     if (!consume(cc::token_type::close_parenthesis))
     {
-        throw std::runtime_error("Expected a ')'");
+        return syntax_error("Expected a ')'");
     }
 
-    bool is_redeclared = scope_.top()->is_declared(identifier.text);
+    bool is_redeclared = symbols_.is_declared(identifier.identifier());
 
     if (!is_redeclared)
     {
-        scope_.top()->declare(identifier.text);
+        symbols_.declare(identifier.identifier(), identifier.location().offset);
     }
 
     if (consume(cc::token_type::semicolon))
     {
-        return std::make_unique<cc::function_declaration>(
+        const auto declaration = builder_.function_declaration(
             type_specifier,
             identifier,
-            nullptr,
+            Builder::none,
             is_redeclared
         );
+
+        declared(identifier, declaration);
+        return declaration;
     }
 
-    if (scope_.top()->is_defined(identifier.text))
+    if (symbols_.is_defined(identifier.identifier()))
     {
-        throw std::runtime_error("Redefinition of " + identifier.text);
+        report(identifier, "Redefinition of '" + std::string(identifier.text()) + "'");
     }
 
-    auto definition = parse_compound_statement();
+    if (body_mode_ == body_mode::defer && symbols_.depth() == 0 && match(cc::token_type::open_brace))
+    {
+        const auto body = current_ref();
+        skip_block();
+        symbols_.define(identifier.identifier(), position());
 
-    if (type_specifier.type != cc::token_type::void_keyword && !definition->returns())
+        const auto declaration = builder_.deferred_function_declaration(type_specifier, identifier, body, is_redeclared, *this);
+        declared(identifier, declaration);
+        return declaration;
+    }
+
+    const auto error_count = diagnostics_.size();
+    const auto definition = parse_function_body();
+
+    if (panicking_)
     {
-        throw std::runtime_error("Not all control paths return a value");
+        return definition;
     }
 
-    scope_.top()->define(identifier.text, true);
+    check_returns(type_specifier, identifier, definition, error_count);
+    symbols_.define(identifier.identifier(), position());
 
-    return std::make_unique<cc::function_declaration>(
+    const auto declaration = builder_.function_declaration(
         type_specifier,
         identifier,
-        std::move(definition),
+        definition,
         is_redeclared
     );
+
+    declared(identifier, declaration);
+    return declaration;
 }
 
-std::unique_ptr<cc::binary_expression> cc::parser::parse_binary_expression()
+template<typename Builder>
+void cc::basic_parser<Builder>::check_returns(cc::token_ref type_specifier,
+                                              cc::token_ref identifier,
+                                              node definition,
+                                              std::size_t error_count)
 {
-    // TODO: Binary expressions should not all be right-associative
+    const bool has_errors = diagnostics_.size() != error_count;
 
-    auto left = parse_primary_expression();
-
-    const auto &op = current_token();
-
-    if (!consume(cc::token_type::plus) && !consume(cc::token_type::assign))
+    if (type_specifier.type() != cc::token_type::void_keyword && !builder_.returns(definition) && !has_errors)
     {
-        throw std::runtime_error("Expected a binary operator");
+        report(identifier, "Not all control paths return a value");
     }
+}
+
+template<>
+cc::compound_statement *cc::basic_parser<cc::syntax_tree_builder>::parse_body(const cc::function_declaration &function)
+{
+    // The file scope is complete by now, so the body only sees what was declared before it, the
+    // same as when it is parsed in place
+    index_ = function.deferred_body().index();
+    symbols_.limit_file_scope(position());
+
+    const auto error_count = diagnostics_.size();
+    const auto definition = parse_compound_statement();
+    symbols_.limit_file_scope(symbol_table::end_of_file);
 
-    auto right = parse_expression();
+    const auto type_specifier = function.trigger_token();
+    check_returns(type_specifier, (*tokens_)[type_specifier.index() + 1], definition, error_count);
 
-    return std::make_unique<cc::binary_expression>(op, std::move(left), std::move(right));
+    return static_cast<cc::compound_statement *>(definition);
 }
 
-std::unique_ptr<cc::expression> cc::parser::parse_expression()
+template<>
+cc::compound_statement *cc::basic_parser<cc::flat_ast_builder>::parse_body(const cc::function_declaration &)
 {
-    const auto &next = peek_token(1);
+    throw std::logic_error("Flat trees never ask for skipped function bodies");
+}
+
+template<typename Builder>
+auto cc::basic_parser<Builder>::parse_expression(cc::precedence lowest) -> node
+{
+    // Operators wait on a stack until the operator after them is known to bind less tightly. Long
+    // chains of operators are therefore parsed in a loop, and only parentheses recurse.
+    const auto first_operand = pending_operands_.size();
+    const auto first_operator = pending_operators_.size();
+
+    const auto reduce = [this] {
+        const auto right = pending_operands_.back();
+        pending_operands_.pop_back();
+
+        auto &left = pending_operands_.back();
+        left = builder_.binary_expression(pending_operators_.back().token, left, right);
+        pending_operators_.pop_back();
+    };
+
+    pending_operands_.push_back(parse_primary_expression());
 
-    if (next.type == cc::token_type::plus || next.type == cc::token_type::assign)
+    while (!panicking_)
     {
-        return parse_binary_expression();
+        // Tokens that are not binary operators have the lowest precedence of all
+        const auto level = cc::binary_precedence(current_type());
+        if (level < lowest)
+        {
+            break;
+        }
+
+        while (pending_operators_.size() > first_operator)
+        {
+            const auto previous = pending_operators_.back().level;
+            if (previous < level || (previous == level && cc::is_right_associative(level)))
+            {
+                break;
+            }
+            reduce();
+        }
+
+        pending_operators_.push_back({current_ref(), level});
+        advance();
+
+        pending_operands_.push_back(parse_primary_expression());
+    }
+
+    // The operand that failed stands in for the whole expression
+    if (panicking_)
+    {
+        const auto error = pending_operands_.back();
+        pending_operands_.erase(pending_operands_.begin() + static_cast<std::ptrdiff_t>(first_operand), pending_operands_.end());
+        pending_operators_.erase(pending_operators_.begin() + static_cast<std::ptrdiff_t>(first_operator), pending_operators_.end());
+        return error;
+    }
+
+    while (pending_operators_.size() > first_operator)
+    {
+        reduce();
     }
 
-    return parse_primary_expression();
+    const auto expression = pending_operands_.back();
+    pending_operands_.pop_back();
+
+    return expression;
 }
 
-std::unique_ptr<cc::statement> cc::parser::parse_expression_statement()
+template<typename Builder>
+auto cc::basic_parser<Builder>::parse_expression_statement() -> node
 {
-    auto expr = parse_expression();
+    const auto expr = parse_expression();
+
+    if (panicking_)
+    {
+        return expr;
+    }
+
     if (!consume(cc::token_type::semicolon))
     {
-        throw std::runtime_error("Expected a ';'");
+        return syntax_error("Expected a ';'");
     }
+
     return expr;
 }
 
-std::unique_ptr<cc::statement> cc::parser::parse_statement()
+template<typename Builder>
+auto cc::basic_parser<Builder>::parse_statement() -> node
 {
-    const auto &current = current_token();
-
-    switch (current.type)
+    switch (current_type())
     {
     case cc::token_type::return_keyword:
         return parse_return_statement();
@@ -315,22 +645,25 @@ std::unique_ptr<cc::statement> cc::parser::parse_statement()
     }
 }
 
-std::unique_ptr<cc::declaration> cc::parser::parse_declaration()
+template<typename Builder>
+auto cc::basic_parser<Builder>::parse_declaration() -> node
 {
-    const auto &type_specifier = current_token();
-
-    if (!consume(cc::token_type::int_keyword))
+    if (!match(cc::token_type::int_keyword))
     {
-        throw std::runtime_error("Expected a type specifier");
+        return syntax_error("Expected a type specifier");
     }
 
-    const auto &identifier = current_token();
+    const auto type_specifier = current_ref();
+    advance();
 
-    if (!consume(cc::token_type::identifier))
+    if (!match(cc::token_type::identifier))
     {
-        throw std::runtime_error("Expected an identifier");
+        return syntax_error("Expected an identifier");
     }
 
+    const auto identifier = current_ref();
+    advance();
+
     if (match(cc::token_type::open_parenthesis))
     {
         return parse_function_declaration(type_specifier, identifier);
@@ -339,15 +672,89 @@ std::unique_ptr<cc::declaration> cc::parser::parse_declaration()
     return parse_variable_declaration(type_specifier, identifier);
 }
 
-std::unique_ptr<cc::translation_unit_declaration> cc::parser::parse_translation_unit()
+template<typename Builder>
+auto cc::basic_parser<Builder>::parse_contents(std::size_t thread_count) -> result
+{
+    if (lexer_ || thread_count <= 1)
+    {
+        return parse_translation_unit();
+    }
+
+    auto outline = basic_parser(*tokens_);
+    outline.body_mode_ = body_mode::skip;
+    outline.parse_translation_unit();
+    bodies_ = std::move(outline.bodies_);
+
+    // Split the bodies into runs of about the same number of tokens, one per thread
+    std::size_t total_size = 0;
+    for (const auto &body : bodies_)
+    {
+        total_size += body.last - body.first;
+    }
+
+    const auto run_count = std::clamp<std::size_t>(bodies_.size(), 1, thread_count);
+    std::vector<std::span<function_body>> runs;
+    runs.reserve(run_count);
+
+    auto run_start = bodies_.begin();
+    std::size_t run_size = 0;
+    for (auto it = bodies_.begin(); it != bodies_.end(); ++it)
+    {
+        run_size += it->last - it->first;
+
+        const bool is_last = std::next(it) == bodies_.end();
+        if (is_last || (runs.size() + 1 < run_count && run_size * run_count >= total_size * (runs.size() + 1)))
+        {
+            runs.emplace_back(run_start, std::next(it));
+            run_start = std::next(it);
+        }
+    }
+
+    // Each run has a parser of its own. The first run is parsed on the calling thread while the
+    // others run in the background.
+    std::deque<basic_parser> parsers;
+    for (std::size_t i = 0; i < runs.size(); i++)
+    {
+        parsers.emplace_back(*tokens_);
+    }
+
+    std::vector<std::future<void>> pending;
+    pending.reserve(runs.size());
+    for (std::size_t i = 1; i < runs.size(); i++)
+    {
+        pending.push_back(std::async(std::launch::async, [&, i] { parsers[i].parse_function_bodies(runs[i], outline.symbols_); }));
+    }
+
+    if (!runs.empty())
+    {
+        parsers.front().parse_function_bodies(runs.front(), outline.symbols_);
+    }
+    for (auto &future : pending)
+    {
+        future.get();
+    }
+
+    body_mode_ = body_mode::adopt;
+    return parse_translation_unit();
+}
+
+template<typename Builder>
+auto cc::basic_parser<Builder>::parse_translation_unit() -> result
 {
-    const auto &first = current_token();
-    std::vector<std::unique_ptr<cc::declaration>> declarations;
+    const auto first = current_ref();
 
     while (!match(cc::token_type::eof))
     {
-        declarations.emplace_back(parse_declaration());
+        pending_children_.push_back(parse_declaration());
+
+        if (panicking_)
+        {
+            synchronize();
+        }
     }
 
-    return std::make_unique<cc::translation_unit_declaration>(first, std::move(declarations));
+    return builder_.translation_unit(first, children_since(0), std::move(retained_));
 }
+
+template class cc::basic_parser<cc::syntax_tree_builder>;
+template class cc::basic_parser<cc::flat_ast_builder>;
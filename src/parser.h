@@ -1,74 +1,225 @@
 #ifndef C_COMPILER_PARSER_H
 #define C_COMPILER_PARSER_H
 
+#include "diagnostics.h"
+#include "flat_ast.h"
+#include "identifier_table.h"
+#include "lexer.h"
+#include "operator_precedence.h"
 #include "symbol_table.h"
+#include "syntax_tree_builder.h"
 #include "token.h"
+#include "token_buffer.h"
 #include "token_type.h"
-#include "syntax/translation_unit_declaration.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
-#include <stack>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
 #include <vector>
 
 namespace cc {
 
-class binary_expression;
-class compound_statement;
-class declaration;
-class declaration_reference_expression;
-class expression;
-class function_declaration;
-class primary_expression;
-class parenthesized_expression;
-class return_statement;
-class statement;
-class syntax_node;
-class variable_declaration;
-
-class parser
+/**
+ * @brief A recursive descent parser. The kind of tree it produces is up to `Builder`, which is
+ *        either a `syntax_tree_builder` or a `flat_ast_builder`.
+ *
+ *        Errors do not stop the parser. Each one is reported to `diagnostics()`, the construct that
+ *        could not be parsed becomes an error node, and parsing resumes at the next statement.
+ */
+template<typename Builder>
+class basic_parser final : private cc::body_parser
 {
-    template <typename T>
-    using const_reference = std::reference_wrapper<const T>;
-
 public:
-    explicit parser(const std::vector<cc::token> &tokens)
-        : index_(0)
-        , tokens_(tokens)
-        , scope_({&symbols_})
+    using node = typename Builder::node;
+    using result = typename Builder::result;
+    using symbol_table = cc::symbol_table<node, Builder::none>;
+
+    /**
+     * @brief Creates a parser over a token buffer that has already been lexed in full. The syntax
+     *        tree refers to tokens in `tokens`, so the buffer must outlive the tree.
+     */
+    explicit basic_parser(const cc::token_buffer &tokens)
+        : tokens_(&tokens)
+        , lexer_(nullptr)
+        , index_(0)
     {
     }
 
-    std::unique_ptr<cc::syntax_node> parse_contents()
+    /**
+     * @brief Creates a parser that pulls tokens from `lexer` as it goes. Only a small window of
+     *        tokens is kept at any one time, so the token stream is never materialized.
+     */
+    explicit basic_parser(cc::lexer &lexer)
+        : window_(cc::token_buffer(lexer.file()))
+        , retained_(std::make_unique<cc::token_buffer>(lexer.file()))
+        , tokens_(&*window_)
+        , lexer_(&lexer)
+        , index_(0)
+    {
+        refill();
+    }
+
+    basic_parser(const basic_parser &) = delete;
+    basic_parser &operator=(const basic_parser &) = delete;
+
+    /**
+     * @brief  Parses the whole token stream. Can only be called once.
+     */
+    result parse_contents()
     {
         return parse_translation_unit();
     }
 
+    /**
+     * @brief  Parses the whole token stream like `parse_contents()`, but parses the bodies of
+     *         functions at file scope on up to `thread_count` threads. The result is identical.
+     *
+     *         The file scope is parsed once without function bodies, which finds the bodies and
+     *         fills in the file-scope symbol table. Each thread then parses a run of bodies with
+     *         its own scopes and nodes, and finally the file scope is parsed again with the bodies
+     *         taken from the threads.
+     *
+     *         Only a parser over a token buffer can parse in parallel. One that streams from a
+     *         lexer parses on the calling thread. Can only be called once.
+     */
+    result parse_contents(std::size_t thread_count);
+
+    /**
+     * @brief  Parses the declarations of the whole token stream, but skips over the bodies of
+     *         functions at file scope by matching braces, which costs little more than lexing.
+     *
+     *         In a class tree, a skipped body is parsed and checked the first time it is asked for
+     *         through `function_declaration::definition()`. The parser builds the body and reports
+     *         its errors to `diagnostics()` then, so it must outlive the tree. A flat tree only
+     *         marks functions whose body was skipped with `flat_ast::deferred_flag`.
+     *
+     *         Only a parser over a token buffer can skip bodies. One that streams from a lexer
+     *         parses them right away. Can only be called once.
+     */
+    result parse_declarations()
+    {
+        if (!lexer_)
+        {
+            body_mode_ = body_mode::defer;
+        }
+
+        return parse_translation_unit();
+    }
+
+    /**
+     * @brief  The errors found while parsing. The tree is only valid if there are none.
+     */
+    const cc::diagnostics &diagnostics() const
+    {
+        return diagnostics_;
+    }
+
 private:
-    const cc::token &current_token() const
+    // Type-only queries read the dense type array of the token buffer. Looking past the end of the
+    // buffer yields the trailing eof token.
+
+    cc::token_type current_type() const
+    {
+        return peek_type(0);
+    }
+
+    cc::token_type peek_type(std::size_t lookahead) const
     {
-        return tokens_.get()[index_];
+        return tokens_->type(std::min(index_ + lookahead, tokens_->size() - 1));
     }
 
-    const cc::token &peek_token(std::size_t lookahead)
+    /**
+     * @brief  The source offset of the current token, which is where symbols declared or defined
+     *         now take effect.
+     */
+    std::uint32_t position() const
+    {
+        return tokens_->location(std::min(index_, tokens_->size() - 1)).offset;
+    }
+
+    /**
+     * @brief  A handle to the current token that stays valid for as long as the syntax tree does.
+     *         When streaming, the token is copied out of the window, which is about to move on.
+     */
+    cc::token_ref current_ref()
     {
-        const auto peek_index = index_ + lookahead;
+        const auto index = std::min(index_, tokens_->size() - 1);
 
-        if (peek_index <= tokens_.get().size())
+        if (!retained_)
         {
-            return tokens_.get()[peek_index];
+            return (*tokens_)[index];
         }
 
-        return tokens_.get().back();
+        retained_->push_back(tokens_->get(index));
+        return (*retained_)[retained_->size() - 1];
+    }
+
+    /**
+     * @brief  The children gathered in `pending_children_` since `first`.
+     */
+    std::span<const node> children_since(std::size_t first) const
+    {
+        return std::span<const node>(pending_children_).subspan(first);
     }
 
     void advance()
     {
-        if (index_ <= tokens_.get().size())
+        if (index_ + 1 < tokens_->size())
         {
             index_++;
         }
+
+        if (lexer_ && index_ + cc::lexer::max_lookahead >= tokens_->size())
+        {
+            refill();
+        }
+    }
+
+    /**
+     * @brief Slides the streaming window forward, dropping consumed tokens and lexing up to
+     *        `window_size` more.
+     */
+    void refill();
+
+    /**
+     * @brief Reports an error in code that parses fine, so parsing carries on as normal.
+     */
+    void report(cc::token_ref token, std::string message)
+    {
+        diagnostics_.error(token.location(), std::move(message));
+    }
+
+    /**
+     * @brief  Reports a syntax error at the current token and starts panicking. Until the parser
+     *         synchronizes, each parse function returns as soon as it sees that a part failed,
+     *         without consuming more tokens, and no further errors are reported.
+     *
+     * @param[in] message What was expected.
+     * @return            An error node to stand in for what could not be parsed.
+     */
+    node syntax_error(std::string message)
+    {
+        if (!panicking_)
+        {
+            diagnostics_.error(tokens_->location(std::min(index_, tokens_->size() - 1)), std::move(message));
+            panicking_ = true;
+        }
+
+        return builder_.error(current_ref());
     }
 
+    /**
+     * @brief Stops panicking by skipping the rest of the statement that could not be parsed: up to
+     *        and including the next ';', or a '{' ... '}' block. The '}' that closes the enclosing
+     *        block is left for the block to consume.
+     */
+    void synchronize();
+
     /**
      * @brief Consumes a token of the specified `token_type`.
      *
@@ -97,37 +248,165 @@ private:
      * @return    `true` if at least one of the arguments matches. `false` otherwise.
      */
     template <typename... Args, typename = std::enable_if_t<are_token_types<Args...>::value>>
-    bool match(const Args &...types) const
+    bool match(const Args &...types)
     {
-        return ((current_token().type == types) || ...);
+        const auto current = current_type();
+        return ((current == types) || ...);
     }
 
     // clang-format off
-    std::unique_ptr<cc::variable_declaration>             parse_variable_declaration(const cc::token &type_specifier, const cc::token &identifier);
-    std::unique_ptr<cc::function_declaration>             parse_function_declaration(const cc::token &type_specifier, const cc::token &identifier);
-    std::unique_ptr<cc::declaration>                      parse_declaration();
-    std::unique_ptr<cc::primary_expression>               parse_literal();
-    std::unique_ptr<cc::parenthesized_expression>         parse_parenthesized_expression();
-    std::unique_ptr<cc::declaration_reference_expression> parse_declaration_reference_expression();
-    std::unique_ptr<cc::primary_expression>               parse_primary_expression();
-    std::unique_ptr<cc::binary_expression>                parse_binary_expression();
-    std::unique_ptr<cc::expression>                       parse_expression();
-    std::unique_ptr<cc::return_statement>                 parse_return_statement();
-    std::unique_ptr<cc::compound_statement>               parse_compound_statement();
-    std::unique_ptr<cc::statement>                        parse_expression_statement();
-    std::unique_ptr<cc::statement>                        parse_statement();
-    std::unique_ptr<cc::translation_unit_declaration>     parse_translation_unit();
+    node   parse_variable_declaration(cc::token_ref type_specifier, cc::token_ref identifier);
+    node   parse_function_declaration(cc::token_ref type_specifier, cc::token_ref identifier);
+    node   parse_declaration();
+    node   parse_literal();
+    node   parse_parenthesized_expression();
+    node   parse_declaration_reference_expression();
+    node   parse_primary_expression();
+    node   parse_expression(cc::precedence lowest = cc::precedence::comma);
+    node   parse_return_statement();
+    node   parse_compound_statement();
+    node   parse_function_body();
+    node   parse_expression_statement();
+    node   parse_statement();
+    result parse_translation_unit();
     // clang-format on
 
+    struct function_body;
+
+    /**
+     * @brief Makes `reference` refer to the declaration of `symbol`, now or once it is built.
+     */
+    void resolve(node reference, cc::identifier_id identifier, const typename symbol_table::symbol &symbol);
+
+    /**
+     * @brief Records the node of a declaration in the current scope, and resolves the references
+     *        to it that were made while it was being parsed.
+     */
+    void declared(cc::token_ref identifier, node declaration);
+
+    /**
+     * @brief Reports a function that should return a value but has no return statement. Bodies
+     *        with errors are let off, as a return statement may well be among what failed to parse.
+     *
+     * @param[in] error_count How many errors had been found before the body was parsed.
+     */
+    void check_returns(cc::token_ref type_specifier, cc::token_ref identifier, node definition, std::size_t error_count);
+
+    /**
+     * @brief Skips a block by matching braces, up to and including its closing '}'.
+     */
+    void skip_block();
+
+    cc::compound_statement *parse_body(const cc::function_declaration &function) override;
+
+    /**
+     * @brief Parses function bodies that were found by an earlier parse of the file scope.
+     *
+     * @param[in] bodies  The bodies to parse, in order. Their results are filled in.
+     * @param[in] globals The complete file scope, which the parser takes a copy of. Each body only
+     *                    sees what was declared before it.
+     */
+    void parse_function_bodies(std::span<function_body> bodies, const symbol_table &globals);
+
 private:
+    static constexpr std::size_t window_size = 1024;
+
+    // How deeply parenthesized expressions may nest. Each level takes a few stack frames.
+    static constexpr std::size_t max_expression_depth = 256;
+
+    // Only engaged when streaming from a lexer. Tokens that the syntax tree refers to are copied
+    // from the window into `retained_`, which the tree takes over once parsing is done.
+    std::optional<cc::token_buffer> window_;
+    std::unique_ptr<cc::token_buffer> retained_;
+    const cc::token_buffer *tokens_;
+    cc::lexer *lexer_;
     std::size_t index_;
-    const_reference<std::vector<cc::token>> tokens_;
-    cc::symbol_table symbols_;
-    std::stack<cc::symbol_table *> scope_;
+
+    symbol_table symbols_;
+
+    struct unresolved_reference
+    {
+        node reference;
+        std::uint32_t binding;
+    };
+
+    struct file_scope_reference
+    {
+        node reference;
+        cc::identifier_id identifier;
+    };
+
+    // References to declarations that are still being parsed, such as a function that calls itself.
+    // They are resolved once the declaration is built, or dropped when their scope ends without it.
+    std::vector<unresolved_reference> unresolved_;
+
+    // Set in a parser that parses function bodies for another one. The file-scope declarations in
+    // its symbol table are not its own, so references to them are left for the other parser.
+    bool detached_ = false;
+    std::vector<file_scope_reference> file_scope_references_;
+
+    cc::diagnostics diagnostics_;
+    bool panicking_ = false;
+
+    // What to do on reaching the body of a function at file scope
+    enum class body_mode
+    {
+        parse,
+        skip,
+        adopt,
+        defer,
+    };
+
+    struct function_body
+    {
+        // Token indices of the opening '{' and of the token after the closing '}'
+        std::size_t first;
+        std::size_t last;
+
+        // The parser that parsed the body, the body it built and the errors it found there
+        basic_parser *parser = nullptr;
+        node root = Builder::none;
+        std::size_t first_diagnostic = 0;
+        std::size_t last_diagnostic = 0;
+
+        // The references to file-scope declarations it made, in `parser->file_scope_references_`
+        std::size_t first_reference = 0;
+        std::size_t last_reference = 0;
+    };
+
+    body_mode body_mode_ = body_mode::parse;
+    std::vector<function_body> bodies_;
+    std::size_t next_body_ = 0;
+
+    Builder builder_;
+
+    // Children of the blocks being parsed, innermost last. A block's children are handed to the
+    // builder once it is complete.
+    std::vector<node> pending_children_;
+
+    struct pending_operator
+    {
+        cc::token_ref token;
+        cc::precedence level;
+    };
+
+    // Operands and operators of the expressions being parsed, innermost last. Only parenthesized
+    // expressions nest, so at most `max_expression_depth` expressions share these.
+    std::vector<node> pending_operands_;
+    std::vector<pending_operator> pending_operators_;
+    std::size_t expression_depth_ = 0;
 };
 
-} // namespace cc
+/**
+ * @brief Parses into a tree of `syntax_node` objects.
+ */
+using parser = cc::basic_parser<cc::syntax_tree_builder>;
+
+/**
+ * @brief Parses into a `flat_ast`.
+ */
+using flat_parser = cc::basic_parser<cc::flat_ast_builder>;
 
-// TODO: Implement better error handling and reporting
+} // namespace cc
 
 #endif
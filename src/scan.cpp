@@ -0,0 +1,439 @@
+#include "scan.h"
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+#if !defined(CCOMPILER_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+#define CCOMPILER_SCAN_SSE2
+#include <immintrin.h>
+
+// AVX2 code is compiled into the same translation unit as the SSE2 code and only called after a
+// runtime check, so the rest of the compiler can still run on CPUs without AVX2.
+#define CCOMPILER_SCAN_AVX2
+#if defined(__GNUC__) || defined(__clang__)
+#define CCOMPILER_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define CCOMPILER_TARGET_AVX2
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+namespace {
+
+// Each scanner describes the chars at which a scan stops, both for a single char and for a whole
+// vector of chars. Vector overloads return a byte mask with 0xFF in every lane that stops the scan.
+
+struct whitespace_end
+{
+    static bool stops(char c)
+    {
+        return !cc::scan::is_space(c);
+    }
+
+#ifdef CCOMPILER_SCAN_SSE2
+    static __m128i stops(__m128i chars)
+    {
+        // '\t', '\n', '\v', '\f' and '\r' are contiguous, so a single range check covers them
+        const __m128i is_control_space = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('\t' - 1)),
+                                                       _mm_cmplt_epi8(chars, _mm_set1_epi8('\r' + 1)));
+        const __m128i is_space = _mm_or_si128(is_control_space, _mm_cmpeq_epi8(chars, _mm_set1_epi8(' ')));
+        return _mm_xor_si128(is_space, _mm_set1_epi8(-1));
+    }
+#endif
+
+#ifdef CCOMPILER_SCAN_AVX2
+    CCOMPILER_TARGET_AVX2 static __m256i stops(__m256i chars)
+    {
+        const __m256i is_control_space = _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8('\t' - 1)),
+                                                          _mm256_cmpgt_epi8(_mm256_set1_epi8('\r' + 1), chars));
+        const __m256i is_space = _mm256_or_si256(is_control_space, _mm256_cmpeq_epi8(chars, _mm256_set1_epi8(' ')));
+        return _mm256_xor_si256(is_space, _mm256_set1_epi8(-1));
+    }
+#endif
+};
+
+struct identifier_end
+{
+    static bool stops(char c)
+    {
+        return !cc::scan::is_identifier_char(c);
+    }
+
+#ifdef CCOMPILER_SCAN_SSE2
+    static __m128i stops(__m128i chars)
+    {
+        // Setting bit 5 folds upper case letters onto lower case ones. No other char is folded into
+        // ['a', 'z'], and bytes with the high bit set compare as negative, so they never match.
+        const __m128i folded = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+        const __m128i is_alpha = _mm_and_si128(_mm_cmpgt_epi8(folded, _mm_set1_epi8('a' - 1)),
+                                               _mm_cmplt_epi8(folded, _mm_set1_epi8('z' + 1)));
+        const __m128i is_digit = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)),
+                                               _mm_cmplt_epi8(chars, _mm_set1_epi8('9' + 1)));
+        const __m128i is_underscore = _mm_cmpeq_epi8(chars, _mm_set1_epi8(cc::chardefs::underscore));
+        const __m128i is_identifier = _mm_or_si128(_mm_or_si128(is_alpha, is_digit), is_underscore);
+        return _mm_xor_si128(is_identifier, _mm_set1_epi8(-1));
+    }
+#endif
+
+#ifdef CCOMPILER_SCAN_AVX2
+    CCOMPILER_TARGET_AVX2 static __m256i stops(__m256i chars)
+    {
+        const __m256i folded = _mm256_or_si256(chars, _mm256_set1_epi8(0x20));
+        const __m256i is_alpha = _mm256_and_si256(_mm256_cmpgt_epi8(folded, _mm256_set1_epi8('a' - 1)),
+                                                  _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), folded));
+        const __m256i is_digit = _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8('0' - 1)),
+                                                  _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), chars));
+        const __m256i is_underscore = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8(cc::chardefs::underscore));
+        const __m256i is_identifier = _mm256_or_si256(_mm256_or_si256(is_alpha, is_digit), is_underscore);
+        return _mm256_xor_si256(is_identifier, _mm256_set1_epi8(-1));
+    }
+#endif
+};
+
+struct string_special
+{
+    static bool stops(char c)
+    {
+        return c == cc::chardefs::quote || c == cc::chardefs::backslash || c == cc::chardefs::cr ||
+               c == cc::chardefs::lf || c == cc::chardefs::eof;
+    }
+
+#ifdef CCOMPILER_SCAN_SSE2
+    static __m128i stops(__m128i chars)
+    {
+        const __m128i quote_or_backslash = _mm_or_si128(_mm_cmpeq_epi8(chars, _mm_set1_epi8(cc::chardefs::quote)),
+                                                        _mm_cmpeq_epi8(chars, _mm_set1_epi8(cc::chardefs::backslash)));
+        const __m128i newline = _mm_or_si128(_mm_cmpeq_epi8(chars, _mm_set1_epi8(cc::chardefs::cr)),
+                                             _mm_cmpeq_epi8(chars, _mm_set1_epi8(cc::chardefs::lf)));
+        const __m128i eof = _mm_cmpeq_epi8(chars, _mm_setzero_si128());
+        return _mm_or_si128(_mm_or_si128(quote_or_backslash, newline), eof);
+    }
+#endif
+
+#ifdef CCOMPILER_SCAN_AVX2
+    CCOMPILER_TARGET_AVX2 static __m256i stops(__m256i chars)
+    {
+        const __m256i quote_or_backslash =
+            _mm256_or_si256(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8(cc::chardefs::quote)),
+                            _mm256_cmpeq_epi8(chars, _mm256_set1_epi8(cc::chardefs::backslash)));
+        const __m256i newline = _mm256_or_si256(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8(cc::chardefs::cr)),
+                                                _mm256_cmpeq_epi8(chars, _mm256_set1_epi8(cc::chardefs::lf)));
+        const __m256i eof = _mm256_cmpeq_epi8(chars, _mm256_setzero_si256());
+        return _mm256_or_si256(_mm256_or_si256(quote_or_backslash, newline), eof);
+    }
+#endif
+};
+
+template <typename Scanner>
+const char *find_first_scalar(const char *first, const char *last)
+{
+    while (first != last && !Scanner::stops(*first))
+    {
+        ++first;
+    }
+    return first;
+}
+
+// Most runs in ordinary code are only a few chars long. Checking those one at a time first avoids
+// paying for a full vector load and mask extraction on every short token.
+constexpr std::ptrdiff_t scalar_prefix_length = 8;
+
+template <typename Scanner>
+bool find_first_in_prefix(const char *&first, const char *last)
+{
+    const char *prefix_end = last - first > scalar_prefix_length ? first + scalar_prefix_length : last;
+
+    first = find_first_scalar<Scanner>(first, prefix_end);
+    return first != prefix_end || first == last;
+}
+
+#ifdef CCOMPILER_SCAN_SSE2
+template <typename Scanner>
+const char *find_first_sse2(const char *first, const char *last)
+{
+    constexpr std::ptrdiff_t width = sizeof(__m128i);
+
+    while (last - first >= width)
+    {
+        const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first));
+        const auto mask = static_cast<std::uint32_t>(_mm_movemask_epi8(Scanner::stops(chars)));
+
+        if (mask != 0)
+        {
+            return first + std::countr_zero(mask);
+        }
+
+        first += width;
+    }
+
+    return find_first_scalar<Scanner>(first, last);
+}
+#endif
+
+#ifdef CCOMPILER_SCAN_AVX2
+template <typename Scanner>
+CCOMPILER_TARGET_AVX2 const char *find_first_avx2(const char *first, const char *last)
+{
+    constexpr std::ptrdiff_t width = sizeof(__m256i);
+
+    while (last - first >= width)
+    {
+        const __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(first));
+        const auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(Scanner::stops(chars)));
+
+        if (mask != 0)
+        {
+            return first + std::countr_zero(mask);
+        }
+
+        first += width;
+    }
+
+    // Fewer than 32 chars left, which may still fill one SSE2 vector
+    return find_first_sse2<Scanner>(first, last);
+}
+
+bool cpu_supports_avx2()
+{
+#if defined(_MSC_VER)
+    int info[4];
+
+    __cpuid(info, 0);
+    if (info[0] < 7)
+    {
+        return false;
+    }
+
+    // The OS must also save the upper halves of the YMM registers on context switches
+    __cpuid(info, 1);
+    const bool has_osxsave = (info[2] & (1 << 27)) != 0;
+    const bool has_avx = (info[2] & (1 << 28)) != 0;
+    if (!has_osxsave || !has_avx || (_xgetbv(0) & 0x6) != 0x6)
+    {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+void find_line_starts_scalar(std::string_view text, std::size_t offset, std::vector<std::uint32_t> &line_starts)
+{
+    for (; offset < text.size(); offset++)
+    {
+        if (text[offset] == cc::chardefs::lf)
+        {
+            line_starts.push_back(static_cast<std::uint32_t>(offset + 1));
+        }
+    }
+}
+
+void push_line_starts(std::uint32_t newline_mask, std::size_t offset, std::vector<std::uint32_t> &line_starts)
+{
+    while (newline_mask != 0)
+    {
+        line_starts.push_back(static_cast<std::uint32_t>(offset + static_cast<std::size_t>(std::countr_zero(newline_mask)) + 1));
+        newline_mask &= newline_mask - 1;
+    }
+}
+
+#ifdef CCOMPILER_SCAN_SSE2
+void find_line_starts_sse2(std::string_view text, std::size_t offset, std::vector<std::uint32_t> &line_starts)
+{
+    constexpr std::size_t width = sizeof(__m128i);
+
+    const __m128i lf = _mm_set1_epi8(cc::chardefs::lf);
+
+    for (; offset + width <= text.size(); offset += width)
+    {
+        const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text.data() + offset));
+        push_line_starts(static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chars, lf))), offset, line_starts);
+    }
+
+    find_line_starts_scalar(text, offset, line_starts);
+}
+#endif
+
+#ifdef CCOMPILER_SCAN_AVX2
+CCOMPILER_TARGET_AVX2 void find_line_starts_avx2(std::string_view text,
+                                                 std::size_t offset,
+                                                 std::vector<std::uint32_t> &line_starts)
+{
+    constexpr std::size_t width = sizeof(__m256i);
+
+    const __m256i lf = _mm256_set1_epi8(cc::chardefs::lf);
+
+    for (; offset + width <= text.size(); offset += width)
+    {
+        const __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text.data() + offset));
+        push_line_starts(static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, lf))), offset, line_starts);
+    }
+
+    find_line_starts_sse2(text, offset, line_starts);
+}
+#endif
+
+using scan_function = const char *(*)(const char *, const char *);
+using line_start_function = void (*)(std::string_view, std::size_t, std::vector<std::uint32_t> &);
+
+struct scan_functions
+{
+    scan_function skip_whitespace;
+    scan_function find_identifier_end;
+    scan_function find_string_special;
+    line_start_function find_line_starts;
+};
+
+template <template <typename> typename Finder>
+constexpr scan_functions make_scan_functions(line_start_function find_line_starts)
+{
+    return {
+        .skip_whitespace     = Finder<whitespace_end>::find,
+        .find_identifier_end = Finder<identifier_end>::find,
+        .find_string_special = Finder<string_special>::find,
+        .find_line_starts    = find_line_starts,
+    };
+}
+
+template <typename Scanner>
+struct scalar_finder
+{
+    static const char *find(const char *first, const char *last)
+    {
+        return find_first_scalar<Scanner>(first, last);
+    }
+};
+
+#ifdef CCOMPILER_SCAN_SSE2
+template <typename Scanner>
+struct sse2_finder
+{
+    static const char *find(const char *first, const char *last)
+    {
+        if (find_first_in_prefix<Scanner>(first, last))
+        {
+            return first;
+        }
+        return find_first_sse2<Scanner>(first, last);
+    }
+};
+#endif
+
+#ifdef CCOMPILER_SCAN_AVX2
+template <typename Scanner>
+struct avx2_finder
+{
+    static const char *find(const char *first, const char *last)
+    {
+        if (find_first_in_prefix<Scanner>(first, last))
+        {
+            return first;
+        }
+        return find_first_avx2<Scanner>(first, last);
+    }
+};
+#endif
+
+scan_functions select_scan_functions()
+{
+#ifdef CCOMPILER_SCAN_AVX2
+    if (cpu_supports_avx2())
+    {
+        return make_scan_functions<avx2_finder>(find_line_starts_avx2);
+    }
+#endif
+
+#ifdef CCOMPILER_SCAN_SSE2
+    return make_scan_functions<sse2_finder>(find_line_starts_sse2);
+#else
+    return make_scan_functions<scalar_finder>(find_line_starts_scalar);
+#endif
+}
+
+const scan_functions &active_scan_functions()
+{
+    static const scan_functions functions = select_scan_functions();
+    return functions;
+}
+
+} // namespace
+
+const char *cc::scan::skip_whitespace(const char *first, const char *last)
+{
+    return active_scan_functions().skip_whitespace(first, last);
+}
+
+const char *cc::scan::find_identifier_end(const char *first, const char *last)
+{
+    return active_scan_functions().find_identifier_end(first, last);
+}
+
+const char *cc::scan::find_string_special(const char *first, const char *last)
+{
+    return active_scan_functions().find_string_special(first, last);
+}
+
+// Comment bodies are skipped with memchr, which the C library already vectorizes. Unlike the scans
+// above, these look for a single char, so there is nothing to gain from a dispatch of our own.
+
+const char *cc::scan::find_line_comment_end(const char *first, const char *last)
+{
+    while (first < last)
+    {
+        const auto *newline = static_cast<const char *>(std::memchr(first, cc::chardefs::lf, static_cast<std::size_t>(last - first)));
+
+        if (!newline)
+        {
+            break;
+        }
+
+        const char *previous = newline - 1;
+        if (previous >= first && *previous == cc::chardefs::cr)
+        {
+            previous--;
+        }
+
+        if (previous < first || *previous != cc::chardefs::backslash)
+        {
+            return newline;
+        }
+
+        first = newline + 1;
+    }
+
+    return last;
+}
+
+const char *cc::scan::find_block_comment_end(const char *first, const char *last)
+{
+    while (first < last)
+    {
+        const auto *asterisk = static_cast<const char *>(std::memchr(first, cc::chardefs::asterisk, static_cast<std::size_t>(last - first)));
+
+        if (!asterisk || asterisk + 1 == last)
+        {
+            break;
+        }
+
+        if (asterisk[1] == cc::chardefs::forward_slash)
+        {
+            return asterisk + 2;
+        }
+
+        first = asterisk + 1;
+    }
+
+    return last;
+}
+
+void cc::scan::find_line_starts(std::string_view text, std::vector<std::uint32_t> &line_starts)
+{
+    active_scan_functions().find_line_starts(text, 0, line_starts);
+}
@@ -0,0 +1,100 @@
+#ifndef C_COMPILER_SCAN_H
+#define C_COMPILER_SCAN_H
+
+#include "definitions.h"
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace cc::scan {
+
+// ASCII-only classification. Unlike <cctype>, these do not depend on the current locale and are
+// well-defined for chars with the high bit set.
+
+constexpr bool is_space(char c)
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+constexpr bool is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+constexpr bool is_alpha(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+constexpr bool is_identifier_start(char c)
+{
+    return is_alpha(c) || c == cc::chardefs::underscore;
+}
+
+constexpr bool is_identifier_char(char c)
+{
+    return is_identifier_start(c) || is_digit(c);
+}
+
+/**
+ * @brief  Finds the end of a run of whitespace.
+ *
+ * @param[in] first The start of the range to scan.
+ * @param[in] last  The end of the range to scan.
+ * @return          A pointer to the first char in [first, last) that is not whitespace, or `last`.
+ */
+const char *skip_whitespace(const char *first, const char *last);
+
+/**
+ * @brief  Finds the end of a run of identifier chars ([A-Za-z0-9_]).
+ *
+ * @param[in] first The start of the range to scan.
+ * @param[in] last  The end of the range to scan.
+ * @return          A pointer to the first char in [first, last) that cannot continue an identifier,
+ *                  or `last`.
+ */
+const char *find_identifier_end(const char *first, const char *last);
+
+/**
+ * @brief  Finds the next char that interrupts the body of a string literal: a quote, a backslash, a
+ *         CR, an LF or a null char.
+ *
+ * @param[in] first The start of the range to scan.
+ * @param[in] last  The end of the range to scan.
+ * @return          A pointer to the first such char in [first, last), or `last`.
+ */
+const char *find_string_special(const char *first, const char *last);
+
+/**
+ * @brief  Finds the end of a line comment: the first LF that is not part of a line continuation (a
+ *         backslash, optionally followed by a CR, right before the LF).
+ *
+ * @param[in] first The first char of the comment body, just past the `//`.
+ * @param[in] last  The end of the range to scan.
+ * @return          A pointer to the LF that ends the comment, or `last`.
+ */
+const char *find_line_comment_end(const char *first, const char *last);
+
+/**
+ * @brief  Finds the end of a block comment.
+ *
+ * @param[in] first The first char of the comment body, just past the opening delimiter.
+ * @param[in] last  The end of the range to scan.
+ * @return          A pointer just past the closing delimiter, or `last` if the comment is not
+ *                  closed.
+ */
+const char *find_block_comment_end(const char *first, const char *last);
+
+/**
+ * @brief Appends the offset just past every LF in `text` to `line_starts`, i.e. the offset of the
+ *        first char of every line after the first.
+ *
+ * @param[in]  text        The text to scan. Must be smaller than 4 GiB.
+ * @param[out] line_starts The vector to append offsets to.
+ */
+void find_line_starts(std::string_view text, std::vector<std::uint32_t> &line_starts);
+
+} // namespace cc::scan
+
+#endif
@@ -0,0 +1,488 @@
+#include "serialized_ast.h"
+
+#include "identifier_table.h"
+#include "token_buffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+constexpr std::array<char, 4> magic = {'C', 'C', 'S', 'T'};
+
+// Written as is, so it reads as the swapped value on a machine with the other byte order
+constexpr std::uint16_t byte_order_mark = 0xFEFF;
+
+constexpr std::size_t section_alignment = 8;
+
+[[noreturn]] void throw_corrupt(const std::string &what)
+{
+    throw std::runtime_error("Corrupt serialized syntax tree: " + what);
+}
+
+constexpr bool is_declaration(cc::syntax_type kind)
+{
+    return kind == cc::syntax_type::variable_declaration || kind == cc::syntax_type::function_declaration;
+}
+
+constexpr bool is_expression(cc::syntax_type kind)
+{
+    switch (kind)
+    {
+    case cc::syntax_type::integer_literal:
+    case cc::syntax_type::double_literal:
+    case cc::syntax_type::float_literal:
+    case cc::syntax_type::string_literal:
+    case cc::syntax_type::char_literal:
+    case cc::syntax_type::binary_expression:
+    case cc::syntax_type::parenthesized_expression:
+    case cc::syntax_type::declaration_reference_expression:
+    case cc::syntax_type::error:
+        return true;
+    default:
+        return false;
+    }
+}
+
+constexpr bool is_compound_statement(cc::syntax_type kind)
+{
+    return kind == cc::syntax_type::compound_statement;
+}
+
+constexpr bool is_statement(cc::syntax_type kind)
+{
+    return kind != cc::syntax_type::translation_unit_declaration;
+}
+
+/**
+ * @brief How many children a node may have, and of which kinds, for it to be converted into a
+ *        `syntax_node` of its class.
+ */
+struct child_rule
+{
+    std::size_t min_count;
+    std::size_t max_count;
+    bool (*accepts)(cc::syntax_type);
+};
+
+constexpr child_rule child_rule_for(cc::syntax_type kind)
+{
+    constexpr auto any_count = std::numeric_limits<std::size_t>::max();
+
+    switch (kind)
+    {
+    case cc::syntax_type::binary_expression:
+        return {2, 2, is_expression};
+    case cc::syntax_type::parenthesized_expression:
+        return {1, 1, is_expression};
+    case cc::syntax_type::return_statement:
+    case cc::syntax_type::variable_declaration:
+        return {0, 1, is_expression};
+    case cc::syntax_type::function_declaration:
+        return {0, 1, is_compound_statement};
+    case cc::syntax_type::compound_statement:
+    case cc::syntax_type::translation_unit_declaration:
+        return {0, any_count, is_statement};
+    default:
+        return {0, 0, is_statement};
+    }
+}
+
+/**
+ * @return Whether the token of a node of kind `kind` has a type that the node can be built from.
+ */
+constexpr bool fits_token(cc::syntax_type kind, cc::token_type type)
+{
+    switch (kind)
+    {
+    case cc::syntax_type::integer_literal:
+        return type == cc::token_type::integer_literal;
+    case cc::syntax_type::double_literal:
+        return type == cc::token_type::double_literal;
+    case cc::syntax_type::float_literal:
+        return type == cc::token_type::float_literal;
+    case cc::syntax_type::string_literal:
+        return type == cc::token_type::string_literal;
+    case cc::syntax_type::char_literal:
+        return type == cc::token_type::char_literal;
+    case cc::syntax_type::declaration_reference_expression:
+        return type == cc::token_type::identifier;
+    default:
+        return true;
+    }
+}
+
+constexpr std::size_t align_section(std::size_t offset)
+{
+    return (offset + section_alignment - 1) / section_alignment * section_alignment;
+}
+
+/**
+ * @return The `count` records of type `T` at `offset` in `bytes`.
+ */
+template<typename T>
+std::span<const T> section(std::span<const std::byte> bytes, std::uint64_t offset, std::uint64_t count)
+{
+    if (offset % alignof(T) != 0)
+    {
+        throw_corrupt("misaligned section");
+    }
+    if (offset > bytes.size() || count > (bytes.size() - offset) / sizeof(T))
+    {
+        throw std::runtime_error("Serialized syntax tree is truncated");
+    }
+
+    return {reinterpret_cast<const T *>(bytes.data() + offset), count};
+}
+
+/**
+ * @brief Collects the strings of a serialized tree, storing each distinct text once.
+ */
+class string_table
+{
+public:
+    std::uint32_t intern(std::string_view text)
+    {
+        const auto [it, inserted] = indices_.try_emplace(text, static_cast<std::uint32_t>(strings_.size()));
+        if (inserted)
+        {
+            if (text.size() > std::numeric_limits<std::uint32_t>::max() - characters_.size())
+            {
+                throw std::length_error("The text of a serialized syntax tree is larger than 4 GiB");
+            }
+
+            strings_.push_back({static_cast<std::uint32_t>(characters_.size()), static_cast<std::uint32_t>(text.size())});
+            characters_ += text;
+        }
+
+        return it->second;
+    }
+
+    const std::vector<cc::serialized_string> &strings() const
+    {
+        return strings_;
+    }
+
+    const std::string &characters() const
+    {
+        return characters_;
+    }
+
+private:
+    // The keys view the token buffer being serialized, which outlives the table
+    std::unordered_map<std::string_view, std::uint32_t> indices_;
+    std::vector<cc::serialized_string> strings_;
+    std::string characters_;
+};
+
+template<typename T>
+void write_records(std::vector<std::byte> &out, std::size_t offset, std::span<const T> records)
+{
+    std::memcpy(out.data() + offset, records.data(), records.size_bytes());
+}
+
+} // namespace
+
+cc::serialized_ast::serialized_ast(std::span<const std::byte> bytes)
+{
+    if (bytes.size() < sizeof(cc::serialized_ast_header))
+    {
+        throw std::runtime_error("Serialized syntax tree is truncated");
+    }
+    if (reinterpret_cast<std::uintptr_t>(bytes.data()) % section_alignment != 0)
+    {
+        throw std::runtime_error("Serialized syntax tree is not aligned to 8 bytes");
+    }
+
+    header_ = reinterpret_cast<const cc::serialized_ast_header *>(bytes.data());
+
+    if (header_->magic != magic)
+    {
+        throw std::runtime_error("Not a serialized syntax tree");
+    }
+    if (header_->byte_order != byte_order_mark)
+    {
+        throw std::runtime_error("Serialized syntax tree was written with a different byte order");
+    }
+    if (header_->version != current_version)
+    {
+        throw std::runtime_error("Unsupported serialized syntax tree version " + std::to_string(header_->version));
+    }
+
+    nodes_ = section<cc::flat_node>(bytes, header_->nodes_offset, header_->node_count);
+    tokens_ = section<cc::serialized_token>(bytes, header_->tokens_offset, header_->token_count);
+    strings_ = section<cc::serialized_string>(bytes, header_->strings_offset, header_->string_count);
+
+    const auto characters = section<char>(bytes, header_->characters_offset, header_->character_count);
+    characters_ = {characters.data(), characters.size()};
+
+    validate_tokens();
+    validate_nodes();
+}
+
+void cc::serialized_ast::validate_tokens() const
+{
+    for (const auto &entry : strings_)
+    {
+        if (std::uint64_t(entry.offset) + entry.length > characters_.size())
+        {
+            throw_corrupt("string out of range");
+        }
+    }
+
+    if (header_->file_name >= strings_.size())
+    {
+        throw_corrupt("file name out of range");
+    }
+
+    for (const auto &token : tokens_)
+    {
+        if (token.type > cc::token_type::unknown)
+        {
+            throw_corrupt("unknown token type");
+        }
+        if (token.text >= strings_.size())
+        {
+            throw_corrupt("token text out of range");
+        }
+        if (token.line == 0 || token.column == 0)
+        {
+            throw_corrupt("token position out of range");
+        }
+    }
+}
+
+void cc::serialized_ast::validate_nodes() const
+{
+    if (nodes_.empty())
+    {
+        throw_corrupt("no translation unit");
+    }
+
+    const auto count = static_cast<cc::node_index>(nodes_.size());
+
+    // Every child comes before its parent, so a walk always ends. A node is the child of at most
+    // one parent, so following the children of every node takes as many steps as there are nodes.
+    std::size_t children_visited = 0;
+
+    for (cc::node_index i = 0; i < count; i++)
+    {
+        const auto &record = nodes_[i];
+
+        if (record.kind > cc::syntax_type::error)
+        {
+            throw_corrupt("unknown node kind");
+        }
+        if ((record.kind == cc::syntax_type::translation_unit_declaration) != (i == count - 1))
+        {
+            throw_corrupt("translation unit that is not the root");
+        }
+        if (record.token >= tokens_.size() || (is_declaration(record.kind) && record.token + 1 >= tokens_.size()))
+        {
+            throw_corrupt("node token out of range");
+        }
+        if (!fits_token(record.kind, tokens_[record.token].type) ||
+            (is_declaration(record.kind) && tokens_[record.token + 1].type != cc::token_type::identifier))
+        {
+            throw_corrupt("node built from the wrong kind of token");
+        }
+        if (record.next_sibling != cc::invalid_node && (record.next_sibling <= i || record.next_sibling >= count))
+        {
+            throw_corrupt("sibling out of order");
+        }
+
+        if (record.kind == cc::syntax_type::declaration_reference_expression)
+        {
+            if (record.first_child != cc::invalid_node &&
+                (record.first_child >= count || !is_declaration(nodes_[record.first_child].kind)))
+            {
+                throw_corrupt("reference to something other than a declaration");
+            }
+            continue;
+        }
+
+        // The children were checked before this node, so their siblings are in range
+        const auto rule = child_rule_for(record.kind);
+        std::size_t child_count = 0;
+        for (auto child = record.first_child; child != cc::invalid_node; child = nodes_[child].next_sibling)
+        {
+            if (child >= i)
+            {
+                throw_corrupt("child after its parent");
+            }
+            if (++children_visited >= count)
+            {
+                throw_corrupt("node shared between parents");
+            }
+            if (++child_count > rule.max_count || !rule.accepts(nodes_[child].kind))
+            {
+                throw_corrupt("unexpected child");
+            }
+        }
+
+        if (child_count < rule.min_count)
+        {
+            throw_corrupt("missing child");
+        }
+    }
+}
+
+std::vector<std::byte> cc::serialize(const cc::flat_ast &ast)
+{
+    const auto &tokens = ast.tokens();
+    const auto &source_file = cc::source_manager::instance().file(tokens.file());
+
+    // Marks the tokens that nodes refer to, then numbers them in source order. Marking the whole
+    // buffer is cheaper than sorting the references.
+    std::vector<std::uint32_t> renumbered(tokens.size(), 0);
+    for (const auto &record : ast.nodes())
+    {
+        renumbered[record.token] = 1;
+        if (is_declaration(record.kind))
+        {
+            renumbered[record.token + 1] = 1;
+        }
+    }
+
+    auto strings = string_table();
+    strings.intern(source_file.name());
+
+    std::vector<cc::serialized_token> kept;
+    for (std::size_t i = 0; i < tokens.size(); i++)
+    {
+        if (renumbered[i] == 0)
+        {
+            continue;
+        }
+
+        renumbered[i] = static_cast<std::uint32_t>(kept.size());
+
+        const auto position = source_file.position(tokens.offset(i));
+        kept.push_back({
+            .type     = tokens.type(i),
+            .reserved = {},
+            .text     = strings.intern(tokens.text(i)),
+            .line     = static_cast<std::uint32_t>(position.line),
+            .column   = static_cast<std::uint32_t>(position.column),
+            .value    = tokens.value(i),
+        });
+    }
+
+    const auto &string_entries = strings.strings();
+    const auto &characters = strings.characters();
+
+    auto header = cc::serialized_ast_header{
+        .magic             = magic,
+        .version           = cc::serialized_ast::current_version,
+        .byte_order        = byte_order_mark,
+        .node_count        = static_cast<std::uint32_t>(ast.size()),
+        .token_count       = static_cast<std::uint32_t>(kept.size()),
+        .string_count      = static_cast<std::uint32_t>(string_entries.size()),
+        .character_count   = static_cast<std::uint32_t>(characters.size()),
+        .file_name         = 0,
+        .source_size       = static_cast<std::uint32_t>(source_file.text().size()),
+        .nodes_offset      = sizeof(cc::serialized_ast_header),
+        .tokens_offset     = 0,
+        .strings_offset    = 0,
+        .characters_offset = 0,
+    };
+    header.tokens_offset = align_section(header.nodes_offset + ast.nodes().size_bytes());
+    header.strings_offset = align_section(header.tokens_offset + kept.size() * sizeof(cc::serialized_token));
+    header.characters_offset = align_section(header.strings_offset + string_entries.size() * sizeof(cc::serialized_string));
+
+    // Padding between sections is zeroed, so the same tree is always written the same way
+    auto out = std::vector<std::byte>(header.characters_offset + characters.size());
+    std::memcpy(out.data(), &header, sizeof(header));
+
+    auto *node_out = out.data() + header.nodes_offset;
+    for (auto record : ast.nodes())
+    {
+        record.token = renumbered[record.token];
+        std::memcpy(node_out, &record, sizeof(record));
+        node_out += sizeof(record);
+    }
+
+    write_records(out, header.tokens_offset, std::span<const cc::serialized_token>(kept));
+    write_records(out, header.strings_offset, std::span<const cc::serialized_string>(string_entries));
+    write_records(out, header.characters_offset, std::span<const char>(characters));
+
+    return out;
+}
+
+cc::flat_ast cc::to_flat_ast(const cc::serialized_ast &file, std::string &source)
+{
+    const auto tokens = file.tokens();
+
+    // Lays out the stand-in source. Decoded literals are read from `file`, so only their position
+    // is kept. Every token is at the same line and column as in the original source, but there is
+    // only whitespace between them, so the stand-in is never larger than the original.
+    std::vector<std::uint32_t> offsets;
+    offsets.reserve(tokens.size());
+    source.clear();
+
+    std::size_t line = 1;
+    std::size_t column = 1;
+    for (const auto &token : tokens)
+    {
+        if (token.line < line || (token.line == line && token.column < column))
+        {
+            throw std::runtime_error("Serialized tokens overlap");
+        }
+
+        // Lines and columns start at 1, and the token does not start before the end of the previous
+        // one, so none of these subtractions wrap. Each part is checked against what is left of the
+        // file on its own, so their sum cannot wrap either.
+        const auto text = cc::token_buffer::can_be_decoded(token.type) ? std::string_view() : file.text(token);
+        const auto newlines = token.line - line;
+        const auto spaces = token.column - (newlines > 0 ? std::size_t(1) : column);
+        const auto remaining = file.source_size() - source.size();
+        if (newlines > remaining || spaces > remaining - newlines || text.size() > remaining - newlines - spaces)
+        {
+            throw std::runtime_error("Serialized tokens do not fit in the source file");
+        }
+
+        source.append(newlines, '\n');
+        source.append(spaces, ' ');
+        offsets.push_back(static_cast<std::uint32_t>(source.size()));
+        source += text;
+
+        line = token.line;
+        column = token.column + text.size();
+        if (const auto last_newline = text.rfind('\n'); last_newline != std::string_view::npos)
+        {
+            line += static_cast<std::size_t>(std::count(text.begin(), text.end(), '\n'));
+            column = text.size() - last_newline;
+        }
+    }
+
+    auto registration = cc::scoped_file(std::string(file.file_name()), source);
+    const auto file_id = registration.id();
+    auto buffer = std::make_unique<cc::token_buffer>(file_id);
+    buffer->reserve(tokens.size());
+
+    const auto view = std::string_view(source);
+    for (std::size_t i = 0; i < tokens.size(); i++)
+    {
+        const auto &token = tokens[i];
+        const auto text = cc::token_buffer::can_be_decoded(token.type) ? file.text(token)
+                                                                         : view.substr(offsets[i], file.text(token).size());
+
+        buffer->push_back({
+            .type       = token.type,
+            .identifier = token.type == cc::token_type::identifier ? cc::identifier_table::instance().intern(text)
+                                                                   : cc::invalid_identifier,
+            .text       = text,
+            .location   = {offsets[i], file_id},
+            .value      = token.value,
+        });
+    }
+
+    const auto &buffer_tokens = *buffer;
+    return {buffer_tokens, std::vector<cc::flat_node>(file.nodes().begin(), file.nodes().end()), std::move(buffer), std::move(registration)};
+}
@@ -0,0 +1,262 @@
+#ifndef C_COMPILER_SERIALIZED_AST_H
+#define C_COMPILER_SERIALIZED_AST_H
+
+#include "flat_ast.h"
+#include "source_manager.h"
+#include "token_type.h"
+#include "syntax/syntax_type.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace cc {
+
+/**
+ * @brief The start of a serialized syntax tree. Every section that follows is an array of plain
+ *        records at an offset that is a multiple of 8, so a mapped file can be read in place.
+ *
+ *        Numbers are stored in the byte order of the machine that wrote the file. A reader on a
+ *        machine with the other byte order sees `byte_order` swapped and rejects the file.
+ */
+struct serialized_ast_header
+{
+    std::array<char, 4> magic;
+    std::uint16_t version;
+    std::uint16_t byte_order;
+
+    std::uint32_t node_count;
+    std::uint32_t token_count;
+    std::uint32_t string_count;
+    std::uint32_t character_count;
+
+    // The index of the name of the source file in the string table, and the size of the file
+    std::uint32_t file_name;
+    std::uint32_t source_size;
+
+    // Byte offsets of the sections from the start of the file
+    std::uint64_t nodes_offset;
+    std::uint64_t tokens_offset;
+    std::uint64_t strings_offset;
+    std::uint64_t characters_offset;
+};
+
+/**
+ * @brief A token that a serialized node refers to. Only the tokens that nodes refer to are stored,
+ *        in the order they appear in the source, so the identifier of a declaration is still the
+ *        token after its type specifier.
+ */
+struct serialized_token
+{
+    cc::token_type type;
+    std::array<std::uint8_t, 3> reserved;
+
+    // The index of the text in the string table. Literals that were decoded by the lexer are
+    // stored decoded.
+    std::uint32_t text;
+
+    std::uint32_t line;
+    std::uint32_t column;
+
+    // As in `cc::token::value`
+    std::uint64_t value;
+};
+
+/**
+ * @brief An entry of the string table: a range of the character section. Each distinct text is
+ *        stored once, however many tokens have it.
+ */
+struct serialized_string
+{
+    std::uint32_t offset;
+    std::uint32_t length;
+};
+
+static_assert(std::is_trivially_copyable_v<cc::serialized_ast_header> && sizeof(cc::serialized_ast_header) == 64);
+static_assert(std::is_trivially_copyable_v<cc::serialized_token> && sizeof(cc::serialized_token) == 24);
+static_assert(std::is_trivially_copyable_v<cc::serialized_string> && sizeof(cc::serialized_string) == 8);
+static_assert(sizeof(cc::flat_node) == 16, "Flat nodes are written to serialized trees as they are");
+
+/**
+ * @brief A read-only view of a serialized syntax tree, as written by `serialize()`. It reads the
+ *        nodes, tokens and strings in place, so a file that is mapped into memory can be walked
+ *        without copying it or allocating anything per node.
+ *
+ *        The nodes are `flat_node` records, laid out as in a `flat_ast`, except that their tokens
+ *        are indices into the token section of the file.
+ */
+class serialized_ast
+{
+public:
+    /**
+     * @brief The version of the format that is written, and the only one that can be read. It is
+     *        bumped by any change to the layout of the file.
+     */
+    static constexpr std::uint16_t current_version = 1;
+
+    /**
+     * @brief Checks a serialized tree once, so that nothing it refers to has to be checked while it
+     *        is walked. The checks take a single pass over the nodes and tokens.
+     *
+     * @param[in] bytes The serialized tree, which must be aligned to 8 bytes, as mapped files and
+     *                  allocations are. It must outlive this view.
+     * @throw std::runtime_error If `bytes` is not a serialized tree of the current version, or is
+     *                           truncated or corrupt.
+     */
+    explicit serialized_ast(std::span<const std::byte> bytes);
+
+    std::uint16_t version() const
+    {
+        return header_->version;
+    }
+
+    std::string_view file_name() const
+    {
+        return string(header_->file_name);
+    }
+
+    std::uint32_t source_size() const
+    {
+        return header_->source_size;
+    }
+
+    cc::node_index root() const
+    {
+        return static_cast<cc::node_index>(nodes_.size() - 1);
+    }
+
+    std::size_t size() const
+    {
+        return nodes_.size();
+    }
+
+    const cc::flat_node &operator[](cc::node_index index) const
+    {
+        return nodes_[index];
+    }
+
+    std::span<const cc::flat_node> nodes() const
+    {
+        return nodes_;
+    }
+
+    std::span<const cc::serialized_token> tokens() const
+    {
+        return tokens_;
+    }
+
+    cc::syntax_type kind(cc::node_index index) const
+    {
+        return nodes_[index].kind;
+    }
+
+    cc::flat_ast::child_range children(cc::node_index index) const
+    {
+        const auto &record = nodes_[index];
+        const auto first = record.kind == cc::syntax_type::declaration_reference_expression ? cc::invalid_node : record.first_child;
+        return {{nodes_.data(), first}, {nodes_.data(), cc::invalid_node}};
+    }
+
+    /**
+     * @brief  The declaration that a declaration reference refers to, or `invalid_node` if it did
+     *         not resolve to one.
+     */
+    cc::node_index declaration(cc::node_index reference) const
+    {
+        return nodes_[reference].first_child;
+    }
+
+    /**
+     * @brief  The token stored in the node. See `flat_node::token`.
+     */
+    const cc::serialized_token &token(cc::node_index index) const
+    {
+        return tokens_[nodes_[index].token];
+    }
+
+    /**
+     * @brief  The token that a `syntax_node` would report as its trigger token. See
+     *         `flat_ast::trigger_token()`.
+     */
+    const cc::serialized_token &trigger_token(cc::node_index index) const
+    {
+        while (nodes_[index].kind == cc::syntax_type::binary_expression)
+        {
+            index = nodes_[index].first_child;
+        }
+        return token(index);
+    }
+
+    /**
+     * @brief  The identifier of a declaration, which is the token after its type specifier.
+     */
+    const cc::serialized_token &identifier(cc::node_index declaration) const
+    {
+        return tokens_[nodes_[declaration].token + 1];
+    }
+
+    bool has_flag(cc::node_index index, std::uint8_t flag) const
+    {
+        return (nodes_[index].flags & flag) != 0;
+    }
+
+    std::string_view text(const cc::serialized_token &token) const
+    {
+        return string(token.text);
+    }
+
+    static cc::source_position position(const cc::serialized_token &token)
+    {
+        return {.line = token.line, .column = token.column};
+    }
+
+    std::string_view string(std::uint32_t index) const
+    {
+        const auto &entry = strings_[index];
+        return characters_.substr(entry.offset, entry.length);
+    }
+
+private:
+    void validate_nodes() const;
+    void validate_tokens() const;
+
+private:
+    const cc::serialized_ast_header *header_;
+    std::span<const cc::flat_node> nodes_;
+    std::span<const cc::serialized_token> tokens_;
+    std::span<const cc::serialized_string> strings_;
+    std::string_view characters_;
+};
+
+/**
+ * @brief  Serializes a flat syntax tree, along with the tokens it refers to, into a single block
+ *         that `serialized_ast` can read back. Nodes that are not reachable from the root are
+ *         written too, so node indices stay the same.
+ * @throw  std::length_error If the text of the tokens does not fit in 4 GiB.
+ */
+std::vector<std::byte> serialize(const cc::flat_ast &ast);
+
+/**
+ * @brief  Reads a serialized tree back into a flat syntax tree, with tokens of its own that report
+ *         the same text and positions as the tokens it was written from. The tokens are read from
+ *         a stand-in for the source file that has the text of every stored token at its original
+ *         line and column. The stand-in is registered under the original name for as long as the
+ *         result lives.
+ *
+ * @param[in]  file   The serialized tree. Decoded literals are read from it, so it must outlive the
+ *                    result.
+ * @param[out] source Receives the text of the stand-in source file. It must outlive the result and
+ *                    must not be changed.
+ * @throw      std::runtime_error If the tokens of `file` overlap each other, or do not fit in a
+ *                                file of the size that was recorded.
+ */
+cc::flat_ast to_flat_ast(const cc::serialized_ast &file, std::string &source);
+
+} // namespace cc
+
+#endif
@@ -0,0 +1,108 @@
+#include "source_manager.h"
+
+#include "scan.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+cc::source_position cc::source_file::position(std::uint32_t offset) const
+{
+    if (offset > text_.size())
+    {
+        throw std::out_of_range("Offset " + std::to_string(offset) + " is past the end of '" + name_ + "'");
+    }
+
+    const auto &starts = line_starts();
+
+    // The first line starts at offset 0, so there is always a line start at or before `offset`
+    const auto next_line = std::upper_bound(starts.begin(), starts.end(), offset);
+    const auto line = static_cast<std::size_t>(next_line - starts.begin());
+
+    return {
+        .line   = line,
+        .column = offset - *std::prev(next_line) + 1,
+    };
+}
+
+const std::vector<std::uint32_t> &cc::source_file::line_starts() const
+{
+    std::call_once(line_starts_built_, [this] {
+        line_starts_.push_back(0);
+        cc::scan::find_line_starts(text_, line_starts_);
+    });
+
+    return line_starts_;
+}
+
+cc::source_manager &cc::source_manager::instance()
+{
+    static source_manager manager;
+    return manager;
+}
+
+cc::file_id cc::source_manager::add_file(std::string name, std::string_view text)
+{
+    if (text.size() > std::numeric_limits<std::uint32_t>::max())
+    {
+        throw std::length_error("Source file '" + name + "' is larger than 4 GiB");
+    }
+
+    const auto lock = std::scoped_lock(mutex_);
+    files_.emplace_back(std::move(name), text);
+    is_removed_.push_back(false);
+    return static_cast<cc::file_id>(files_.size() - 1);
+}
+
+void cc::source_manager::replace_file(cc::file_id id, std::string_view text)
+{
+    const auto lock = std::scoped_lock(mutex_);
+    check_file(id);
+    auto &file = files_[id];
+
+    if (text.size() > std::numeric_limits<std::uint32_t>::max())
+    {
+        throw std::length_error("Source file '" + std::string(file.name()) + "' is larger than 4 GiB");
+    }
+
+    reset_file(file, std::string(file.name()), text);
+}
+
+void cc::source_manager::remove_file(cc::file_id id)
+{
+    const auto lock = std::scoped_lock(mutex_);
+    check_file(id);
+    reset_file(files_[id], {}, {});
+    is_removed_[id] = true;
+}
+
+void cc::source_manager::reset_file(cc::source_file &file, std::string name, std::string_view text)
+{
+    // The line table is built at most once per source_file, so the entry is made again rather than
+    // assigned to. source_file has no const or reference members, so references to the old entry
+    // refer to the new one.
+    std::destroy_at(&file);
+    std::construct_at(&file, std::move(name), text);
+}
+
+void cc::source_manager::check_file(cc::file_id id) const
+{
+    if (id >= files_.size())
+    {
+        throw std::out_of_range("No source file has id " + std::to_string(id));
+    }
+    if (is_removed_[id])
+    {
+        throw std::out_of_range("Source file " + std::to_string(id) + " has been removed");
+    }
+}
+
+const cc::source_file &cc::source_manager::file(cc::file_id id) const
+{
+    const auto lock = std::scoped_lock(mutex_);
+    check_file(id);
+    return files_[id];
+}
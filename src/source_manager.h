@@ -0,0 +1,248 @@
+#ifndef C_COMPILER_SOURCE_MANAGER_H
+#define C_COMPILER_SOURCE_MANAGER_H
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace cc {
+
+using file_id = std::uint32_t;
+
+/**
+ * @brief A compact reference to a position in a source file. Line and column are only computed
+ *        when a position is actually displayed.
+ */
+struct source_location
+{
+    std::uint32_t offset;
+    cc::file_id file;
+
+    bool operator==(const source_location &) const = default;
+};
+
+/**
+ * @brief A resolved, human-readable position in a source file. Both line and column start at 1.
+ */
+struct source_position
+{
+    std::size_t line;
+    std::size_t column;
+
+    std::string to_string(std::string_view open = "(", std::string_view close = ")") const
+    {
+        std::string result;
+        result.reserve(open.size() + close.size() + 2 * std::numeric_limits<std::size_t>::digits10 + 1);
+        append_to(result, open, close);
+        return result;
+    }
+
+    /**
+     * @brief Appends the position to `out` in the same format as `to_string()`.
+     */
+    void append_to(std::string &out, std::string_view open = "(", std::string_view close = ")") const
+    {
+        char digits[std::numeric_limits<std::size_t>::digits10 + 1];
+
+        out += open;
+        out.append(digits, std::to_chars(std::begin(digits), std::end(digits), line).ptr);
+        out += ',';
+        out.append(digits, std::to_chars(std::begin(digits), std::end(digits), column).ptr);
+        out += close;
+    }
+
+    bool operator==(const source_position &) const = default;
+};
+
+class source_file
+{
+public:
+    source_file(std::string name, std::string_view text)
+        : name_(std::move(name))
+        , text_(text)
+    {
+    }
+
+    std::string_view name() const
+    {
+        return name_;
+    }
+
+    std::string_view text() const
+    {
+        return text_;
+    }
+
+    /**
+     * @brief  Resolves a byte offset into a line and column. The first call builds the file's line
+     *         table; every call after that is a binary search.
+     *
+     * @param[in] offset A byte offset into the file. The end of the file is a valid offset.
+     * @return           The line and column of `offset`.
+     * @throw std::out_of_range If `offset` is past the end of the file, which means the location
+     *                          was not made from this text.
+     */
+    cc::source_position position(std::uint32_t offset) const;
+
+private:
+    const std::vector<std::uint32_t> &line_starts() const;
+
+private:
+    std::string name_;
+    std::string_view text_;
+
+    mutable std::once_flag line_starts_built_;
+    mutable std::vector<std::uint32_t> line_starts_;
+};
+
+/**
+ * @brief Registry of every source file seen by the compiler. Files are referred to by a `file_id`,
+ *        which is what allows a `source_location` to stay small.
+ */
+class source_manager
+{
+public:
+    static source_manager &instance();
+
+    /**
+     * @brief  Registers a source file. The text is not copied, so it must outlive every use of the
+     *         returned id.
+     *
+     * @param[in] name The name shown in diagnostics.
+     * @param[in] text The contents of the file.
+     * @return         The id of the new file.
+     * @throw std::length_error If the file is too large for 32-bit offsets.
+     */
+    cc::file_id add_file(std::string name, std::string_view text);
+
+    /**
+     * @brief  Points a registered file at new text, such as an edited copy of a buffer, keeping its
+     *         id and name. Its line table is built again when a position is next resolved. The
+     *         previous text may be freed once this returns, provided nothing else still refers to
+     *         it. No other thread may be using the file while it is replaced.
+     *
+     * @param[in] id   The file to replace.
+     * @param[in] text The new contents of the file, which must outlive every use of `id`.
+     * @throw std::length_error If the file is too large for 32-bit offsets.
+     */
+    void replace_file(cc::file_id id, std::string_view text);
+
+    /**
+     * @brief  Releases the text, name and line table of a file that is no longer needed. The id is
+     *         never given to another file, so a location that outlives the file cannot resolve into
+     *         a different one: looking it up throws instead.
+     */
+    void remove_file(cc::file_id id);
+
+    /**
+     * @throw std::out_of_range If no file was registered under `id`, or it has been removed.
+     */
+    const cc::source_file &file(cc::file_id id) const;
+
+    cc::source_position position(cc::source_location location) const
+    {
+        return file(location.file).position(location.offset);
+    }
+
+private:
+    source_manager() = default;
+
+private:
+    /**
+     * @brief Replaces a file in place, so that references to the entry stay valid.
+     */
+    static void reset_file(cc::source_file &file, std::string name, std::string_view text);
+
+    /**
+     * @brief Throws `std::out_of_range` unless `id` is a registered file that has not been removed.
+     *        Must be called with `mutex_` held.
+     */
+    void check_file(cc::file_id id) const;
+
+private:
+    // A deque never relocates its elements, so references returned by file() stay valid
+    std::deque<cc::source_file> files_;
+
+    // Whether each file has been removed. Removed entries stay behind, emptied, so ids are unique.
+    std::vector<bool> is_removed_;
+    mutable std::mutex mutex_;
+};
+
+/**
+ * @brief Registers a file with the `source_manager` for as long as it lives, for buffers that only
+ *        need an id while they are being worked on. The file is removed when this is destroyed,
+ *        after which resolving a location in it throws.
+ */
+class scoped_file
+{
+public:
+    scoped_file() = default;
+
+    /**
+     * @throw std::length_error If the file is too large for 32-bit offsets.
+     */
+    scoped_file(std::string name, std::string_view text)
+        : id_(cc::source_manager::instance().add_file(std::move(name), text))
+        , is_registered_(true)
+    {
+    }
+
+    scoped_file(scoped_file &&other) noexcept
+        : id_(other.id_)
+        , is_registered_(std::exchange(other.is_registered_, false))
+    {
+    }
+
+    scoped_file &operator=(scoped_file &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            id_ = other.id_;
+            is_registered_ = std::exchange(other.is_registered_, false);
+        }
+        return *this;
+    }
+
+    ~scoped_file()
+    {
+        release();
+    }
+
+    cc::file_id id() const
+    {
+        return id_;
+    }
+
+private:
+    void release()
+    {
+        if (is_registered_)
+        {
+            cc::source_manager::instance().remove_file(id_);
+            is_registered_ = false;
+        }
+    }
+
+private:
+    cc::file_id id_ = 0;
+    bool is_registered_ = false;
+};
+
+} // namespace cc
+
+inline std::ostream &operator<<(std::ostream &os, cc::source_position pos)
+{
+    return os << pos.to_string();
+}
+
+#endif
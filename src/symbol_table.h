@@ -1,89 +1,343 @@
 #ifndef C_COMPILER_SYMBOL_TABLE_H
 #define C_COMPILER_SYMBOL_TABLE_H
 
-#include "token.h"
+#include "identifier_table.h"
 
-#include <any>
-#include <stdexcept>
-#include <unordered_map>
-
-// TODO: table_type::value_type::second_type should contain symbol information
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
 
 namespace cc {
 
+/**
+ * @brief The symbols of every scope that is currently open, in a single table. Each name maps to
+ *        its innermost binding, which links to the binding of the same name that it hides, so
+ *        looking up a name takes the same time at any depth.
+ *
+ *        Bindings are kept in the order they were made, which doubles as an undo log: leaving a
+ *        scope pops exactly the bindings it made and uncovers the ones they hid.
+ *
+ * @tparam Declaration A handle to the declaration node that a symbol refers to.
+ * @tparam none        The handle of a declaration whose node has not been built (yet).
+ */
+template<typename Declaration, Declaration none>
 class symbol_table
 {
-    using table_type = std::unordered_map<std::string_view, bool>;
+    struct binding
+    {
+        cc::identifier_id identifier;
+
+        // The first declaration of the symbol that was built
+        Declaration declaration;
+
+        // Source offsets of the points from which the symbol is declared and defined
+        std::uint32_t declared_at;
+        std::uint32_t defined_at;
+
+        // The depth of the scope the binding was made in, and the binding of the same name it hides
+        std::uint32_t depth;
+        std::uint32_t shadowed;
+    };
+
+    // A name and its innermost binding. A name that goes out of scope keeps its slot with no
+    // binding, so slots are never removed and probing never has to step over deleted ones.
+    struct slot
+    {
+        cc::identifier_id identifier;
+        std::uint32_t binding;
+    };
 
 public:
-    explicit symbol_table(const symbol_table *enclosing = nullptr)
-        : enclosing_(enclosing)
+    /**
+     * @brief A source offset past every symbol.
+     */
+    static constexpr std::uint32_t end_of_file = std::numeric_limits<std::uint32_t>::max();
+
+    /**
+     * @brief What a name refers to in the current scope.
+     */
+    struct symbol
+    {
+        // The declaration node, or `none` while it is still being parsed or if it failed to parse
+        Declaration declaration;
+
+        // Identifies the binding for as long as its scope is open
+        std::uint32_t binding;
+
+        bool is_defined;
+        bool is_file_scope;
+    };
+
+    symbol_table()
+        : slots_(initial_capacity, {cc::invalid_identifier, no_binding})
     {
     }
 
-    table_type::value_type::second_type get(table_type::key_type identifier) const
+    /**
+     * @brief How many scopes are open besides the file scope.
+     */
+    std::size_t depth() const
     {
-        if (const auto it = symbols_.find(identifier); it != symbols_.end())
-        {
-            return it->second;
-        }
+        return scopes_.size();
+    }
 
-        if (enclosing_)
+    void enter_scope()
+    {
+        scopes_.push_back(bindings_.size());
+    }
+
+    /**
+     * @brief Pops the bindings made since the matching `enter_scope()`, newest first.
+     */
+    void leave_scope()
+    {
+        const auto first = scopes_.back();
+        scopes_.pop_back();
+
+        while (bindings_.size() > first)
         {
-            return enclosing_->get(identifier);
+            const auto &undone = bindings_.back();
+            slots_[find(undone.identifier)].binding = undone.shadowed;
+            bindings_.pop_back();
         }
+    }
 
-        throw std::runtime_error("Identifier '" + std::string(identifier) + "' is undefined");
+    /**
+     * @brief Only lets symbols of the file scope be seen as declared or defined if that happened
+     *        before `visible_until`. A function body that is parsed out of order uses it to see the
+     *        complete file scope as it was at the start of the body.
+     */
+    void limit_file_scope(std::uint32_t visible_until)
+    {
+        file_scope_visible_until_ = visible_until;
     }
 
-    bool is_declared(table_type::key_type identifier) const
+    /**
+     * @brief  Looks up the innermost binding of a symbol.
+     * @return The symbol, or nothing if it has not been declared.
+     */
+    std::optional<symbol> lookup(cc::identifier_id identifier) const
     {
-        if (is_declared_in_scope(identifier))
+        const auto index = innermost(identifier);
+
+        if (index == no_binding || !is_visible(bindings_[index]))
         {
-            return true;
+            return std::nullopt;
         }
 
-        if (enclosing_)
+        const auto &found = bindings_[index];
+        return symbol{found.declaration, index, is_visibly_defined(found), found.depth == 0};
+    }
+
+    /**
+     * @brief  Looks up the innermost binding of a symbol.
+     * @return Whether the symbol is defined, or nothing if it has not been declared.
+     */
+    std::optional<bool> get(cc::identifier_id identifier) const
+    {
+        const auto found = lookup(identifier);
+        return found ? std::optional<bool>(found->is_defined) : std::nullopt;
+    }
+
+    bool is_declared(cc::identifier_id identifier) const
+    {
+        return get(identifier).has_value();
+    }
+
+    bool is_declared_in_scope(cc::identifier_id identifier) const
+    {
+        const auto index = innermost(identifier);
+        return index != no_binding && bindings_[index].depth == depth();
+    }
+
+    /**
+     * @brief Whether the symbol is defined in the current scope or any scope around it, even if the
+     *        definition is hidden by a declaration.
+     */
+    bool is_defined(cc::identifier_id identifier) const
+    {
+        for (auto index = innermost(identifier); index != no_binding; index = bindings_[index].shadowed)
         {
-            return enclosing_->is_declared(identifier);
+            if (is_visible(bindings_[index]) && is_visibly_defined(bindings_[index]))
+            {
+                return true;
+            }
         }
 
         return false;
     }
 
-    bool is_declared_in_scope(table_type::key_type identifier) const
+    /**
+     * @brief Declares a symbol in the current scope, unless it already is.
+     *
+     * @param[in] position The source offset the declaration takes effect at.
+     */
+    void declare(cc::identifier_id identifier, std::uint32_t position)
+    {
+        auto &entry = slot_for(identifier);
+
+        if (entry.binding == no_binding || bindings_[entry.binding].depth != depth())
+        {
+            entry.binding = bind(identifier, position, end_of_file, entry.binding);
+        }
+    }
+
+    /**
+     * @brief Defines a symbol in the current scope, declaring it first if need be. Of several
+     *        definitions, the first one counts.
+     *
+     * @param[in] position The source offset the definition takes effect at.
+     */
+    void define(cc::identifier_id identifier, std::uint32_t position)
     {
-        return symbols_.find(identifier) != symbols_.end();
+        auto &entry = slot_for(identifier);
+
+        if (entry.binding == no_binding || bindings_[entry.binding].depth != depth())
+        {
+            entry.binding = bind(identifier, position, position, entry.binding);
+        }
+        else
+        {
+            auto &defined_at = bindings_[entry.binding].defined_at;
+            defined_at = std::min(defined_at, position);
+        }
     }
 
-    bool is_defined(table_type::key_type identifier) const
+    /**
+     * @brief  Records the node of a symbol declared in the current scope, unless it already has one.
+     * @return The binding of the symbol, or nothing if it is not declared in the current scope.
+     */
+    std::optional<std::uint32_t> set_declaration(cc::identifier_id identifier, Declaration declaration)
     {
-        if (get(identifier))
+        const auto index = innermost(identifier);
+
+        if (index == no_binding || bindings_[index].depth != depth())
         {
-            return true;
+            return std::nullopt;
         }
 
-        if (enclosing_)
+        if (bindings_[index].declaration == none)
         {
-            return enclosing_->is_defined(identifier);
+            bindings_[index].declaration = declaration;
         }
 
-        return false;
+        return index;
+    }
+
+    /**
+     * @brief How many bindings are in scope. Bindings from `size()` on have gone out of scope.
+     */
+    std::size_t size() const
+    {
+        return bindings_.size();
+    }
+
+private:
+    std::uint32_t visible_until(const binding &b) const
+    {
+        return b.depth == 0 ? file_scope_visible_until_ : end_of_file;
+    }
+
+    bool is_visible(const binding &b) const
+    {
+        return b.declared_at < visible_until(b);
     }
 
-    void declare(table_type::key_type identifier)
+    bool is_visibly_defined(const binding &b) const
     {
-        symbols_.insert({identifier, false});
+        return b.defined_at < visible_until(b);
     }
 
-    void define(table_type::key_type identifier, table_type::value_type::second_type value)
+    std::uint32_t bind(cc::identifier_id identifier, std::uint32_t declared_at, std::uint32_t defined_at, std::uint32_t shadowed)
     {
-        symbols_.insert_or_assign(identifier, value);
+        const auto index = static_cast<std::uint32_t>(bindings_.size());
+        bindings_.push_back({
+            .identifier  = identifier,
+            .declaration = none,
+            .declared_at = declared_at,
+            .defined_at  = defined_at,
+            .depth       = static_cast<std::uint32_t>(depth()),
+            .shadowed    = shadowed,
+        });
+        return index;
+    }
+
+    /**
+     * @brief  The index of the slot of `identifier`, or of the empty slot it would go in.
+     */
+    std::size_t find(cc::identifier_id identifier) const
+    {
+        // Identifier ids are dense, so they spread over the slots well enough as they are
+        const auto mask = slots_.size() - 1;
+        auto i = identifier & mask;
+
+        while (slots_[i].identifier != identifier && slots_[i].identifier != cc::invalid_identifier)
+        {
+            i = (i + 1) & mask;
+        }
+
+        return i;
+    }
+
+    std::uint32_t innermost(cc::identifier_id identifier) const
+    {
+        return slots_[find(identifier)].binding;
+    }
+
+    /**
+     * @brief  The slot of `identifier`, which is added if the table has never seen it.
+     */
+    slot &slot_for(cc::identifier_id identifier)
+    {
+        auto i = find(identifier);
+
+        if (slots_[i].identifier == cc::invalid_identifier)
+        {
+            if ((used_slots_ + 1) * 2 > slots_.size())
+            {
+                grow();
+                i = find(identifier);
+            }
+
+            used_slots_++;
+            slots_[i].identifier = identifier;
+        }
+
+        return slots_[i];
+    }
+
+    void grow()
+    {
+        auto old_slots = std::vector<slot>(slots_.size() * 2, {cc::invalid_identifier, no_binding});
+        old_slots.swap(slots_);
+
+        for (const auto &entry : old_slots)
+        {
+            if (entry.identifier == cc::invalid_identifier)
+            {
+                continue;
+            }
+
+            slots_[find(entry.identifier)] = entry;
+        }
     }
 
 private:
-    table_type symbols_;
-    const symbol_table *enclosing_;
+    static constexpr std::size_t initial_capacity = 64;
+    static constexpr std::uint32_t no_binding = std::numeric_limits<std::uint32_t>::max();
+
+    // Open addressing with linear probing. Empty slots have an identifier of `invalid_identifier`.
+    std::vector<slot> slots_;
+    std::size_t used_slots_ = 0;
+
+    // Every binding in scope, oldest first, and where each open scope's bindings start
+    std::vector<binding> bindings_;
+    std::vector<std::size_t> scopes_;
+
+    std::uint32_t file_scope_visible_until_ = end_of_file;
 };
 
 } // namespace cc
@@ -1,47 +1,44 @@
 #ifndef C_COMPILER_BINARY_EXPRESSION_H
 #define C_COMPILER_BINARY_EXPRESSION_H
 
-#include "token.h"
+#include "token_buffer.h"
 #include "syntax/expression.h"
 #include "syntax/syntax_type.h"
 
-#include <utility>
+#include <array>
 
 namespace cc {
 
 class binary_expression : public cc::expression
 {
 public:
-    binary_expression(cc::token op,
-                      std::unique_ptr<cc::expression> left,
-                      std::unique_ptr<cc::expression> right)
-        : cc::expression(left->trigger_token())
-        , operator_(std::move(op))
-        , left_(std::move(left))
-        , right_(std::move(right))
+    binary_expression(cc::token_ref op,
+                      cc::expression *left,
+                      cc::expression *right)
+        : cc::expression(left->trigger_token(), cc::syntax_type::binary_expression)
+        , operator_(op)
+        , operands_({left, right})
     {
-        children_.push_back(left_.get());
-        children_.push_back(right_.get());
+        children_ = operands_;
     }
 
-    cc::syntax_type type() const override
+    void describe(std::string &out) const override
     {
-        return cc::syntax_type::binary_expression;
+        out += "binary_expression ";
+        source_position().append_to(out, "<", ">");
+        out += " '";
+        out += operator_.text();
+        out += '\'';
     }
 
-    std::string to_string() const override
+    cc::token_ref operator_token() const
     {
-        const auto &pos = trigger_token().pos;
-
-        return "binary_expression"         " "
-               + pos.to_string("<", ">") + " "
-               "'" + operator_.text      + "'";
+        return operator_;
     }
 
 private:
-    cc::token operator_;
-    std::unique_ptr<cc::expression> left_;
-    std::unique_ptr<cc::expression> right_;
+    cc::token_ref operator_;
+    std::array<cc::syntax_node *, 2> operands_;
 };
 
 } // namespace cc
@@ -1,40 +1,31 @@
 #ifndef C_COMPILER_COMPOUND_STATEMENT_H
 #define C_COMPILER_COMPOUND_STATEMENT_H
 
-#include "token.h"
+#include "token_buffer.h"
 #include "syntax/statement.h"
 #include "syntax/syntax_type.h"
 
-#include <memory>
+#include <span>
 
 namespace cc {
 
 class compound_statement : public cc::statement
 {
 public:
-    explicit compound_statement(const cc::token &trigger_token)
-        : cc::statement(trigger_token)
+    /**
+     * @param[in] statements The statements in the block, in an array that lives as long as the node.
+     */
+    compound_statement(cc::token_ref trigger_token, std::span<cc::syntax_node *const> statements)
+        : cc::statement(trigger_token, cc::syntax_type::compound_statement)
         , has_return_(false)
     {
+        children_ = statements;
     }
 
-    void add_statement(std::unique_ptr<cc::statement> statement)
+    void describe(std::string &out) const override
     {
-        statements_.emplace_back(std::move(statement));
-        children_.push_back(statements_.back().get());
-    }
-
-    cc::syntax_type type() const override
-    {
-        return cc::syntax_type::compound_statement;
-    }
-
-    std::string to_string() const override
-    {
-        const auto &pos = trigger_token().pos;
-
-        return "compound_statement"  " "
-               + pos.to_string("<", ">");
+        out += "compound_statement ";
+        source_position().append_to(out, "<", ">");
     }
 
     bool returns() const
@@ -48,7 +39,6 @@ public:
     }
 
 private:
-    std::vector<std::unique_ptr<cc::statement>> statements_;
     bool has_return_;
 };
 
@@ -1,7 +1,8 @@
 #ifndef C_COMPILER_DECLARATION_H
 #define C_COMPILER_DECLARATION_H
 
-#include "token.h"
+#include "token_buffer.h"
+#include "syntax/syntax_type.h"
 #include "syntax/statement.h"
 #include "syntax/syntax_node.h"
 
@@ -18,8 +19,8 @@ public:
     declaration &operator=(declaration &&) = delete;
 
 protected:
-    explicit declaration(const cc::token &trigger_token)
-        : cc::statement(trigger_token)
+    declaration(cc::token_ref trigger_token, cc::syntax_type type)
+        : cc::statement(trigger_token, type)
     {
     }
 };
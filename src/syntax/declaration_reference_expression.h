@@ -1,7 +1,9 @@
 #ifndef C_COMPILER_DECLARATION_REFERENCE_EXPRESSION_H
 #define C_COMPILER_DECLARATION_REFERENCE_EXPRESSION_H
 
-#include "token.h"
+#include "identifier_table.h"
+#include "token_buffer.h"
+#include "syntax/declaration.h"
 #include "syntax/primary_expression.h"
 #include "syntax/syntax_type.h"
 
@@ -10,24 +12,46 @@ namespace cc {
 class declaration_reference_expression : public cc::primary_expression
 {
 public:
-    explicit declaration_reference_expression(const cc::token &trigger_token)
-        : cc::primary_expression(trigger_token)
+    explicit declaration_reference_expression(cc::token_ref trigger_token)
+        : cc::primary_expression(trigger_token, cc::syntax_type::declaration_reference_expression)
     {
     }
 
-    cc::syntax_type type() const override
+    void describe(std::string &out) const override
     {
-        return cc::syntax_type::declaration_reference_expression;
+        out += "declaration_reference_expression ";
+        source_position().append_to(out, "<", ">");
+        out += " lvalue Var '";
+        out += name();
+        out += '\'';
     }
 
-    std::string to_string() const override
+    cc::identifier_id identifier() const
     {
-        const auto &[_, text, pos] = trigger_token();
+        return trigger_token().identifier();
+    }
 
-        return "declaration_reference_expression"  " "
-               + pos.to_string("<", ">")         + " "
-               "lvalue Var '" + text + "'";
+    std::string_view name() const
+    {
+        return cc::identifier_table::instance().text(identifier());
+    }
+
+    /**
+     * @brief  The declaration that the name resolved to when it was parsed, or null if it did not
+     *         resolve to one.
+     */
+    const cc::declaration *declaration() const
+    {
+        return declaration_;
     }
+
+    void resolve(const cc::declaration &declaration)
+    {
+        declaration_ = &declaration;
+    }
+
+private:
+    const cc::declaration *declaration_ = nullptr;
 };
 
 } // namespace cc
@@ -0,0 +1,31 @@
+#ifndef C_COMPILER_ERROR_NODE_H
+#define C_COMPILER_ERROR_NODE_H
+
+#include "token_buffer.h"
+#include "syntax/expression.h"
+#include "syntax/syntax_type.h"
+
+namespace cc {
+
+/**
+ * @brief Stands in for an expression, statement or declaration that could not be parsed. The
+ *        trigger token is where the error was found.
+ */
+class error_node : public cc::expression
+{
+public:
+    explicit error_node(cc::token_ref trigger_token)
+        : cc::expression(trigger_token, cc::syntax_type::error)
+    {
+    }
+
+    void describe(std::string &out) const override
+    {
+        out += "error_node ";
+        source_position().append_to(out, "<", ">");
+    }
+};
+
+} // namespace cc
+
+#endif
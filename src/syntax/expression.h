@@ -1,7 +1,8 @@
 #ifndef C_COMPILER_EXPRESSION_H
 #define C_COMPILER_EXPRESSION_H
 
-#include "token.h"
+#include "token_buffer.h"
+#include "syntax/syntax_type.h"
 #include "syntax/statement.h"
 
 namespace cc {
@@ -17,8 +18,8 @@ public:
     expression &operator=(expression &&) = delete;
 
 protected:
-    explicit expression(const cc::token &trigger_token)
-        : cc::statement(trigger_token)
+    expression(cc::token_ref trigger_token, cc::syntax_type type)
+        : cc::statement(trigger_token, type)
     {
     }
 };
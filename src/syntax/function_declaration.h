@@ -1,79 +1,153 @@
 #ifndef C_COMPILER_FUNCTION_DECLARATION_H
 #define C_COMPILER_FUNCTION_DECLARATION_H
 
-#include "token.h"
+#include "identifier_table.h"
+#include "token_buffer.h"
 #include "syntax/compound_statement.h"
 #include "syntax/declaration.h"
 #include "syntax/syntax_type.h"
 
+#include <cstddef>
 #include <utility>
 
 namespace cc {
 
+class function_declaration;
+
+/**
+ * @brief Parses the body of a function that was skipped, once the body is asked for.
+ */
+class body_parser
+{
+public:
+    /**
+     * @brief  Parses the body of `function`, which starts at `function.deferred_body()`. Errors in
+     *         the body are reported by the parser as usual.
+     */
+    virtual cc::compound_statement *parse_body(const cc::function_declaration &function) = 0;
+
+protected:
+    ~body_parser() = default;
+};
+
 class function_declaration : public cc::declaration
 {
 public:
-    function_declaration(const cc::token &type_specifier,
-                         cc::token identifier,
-                         std::unique_ptr<cc::compound_statement> definition = nullptr,
+    function_declaration(cc::token_ref type_specifier,
+                         cc::token_ref identifier,
+                         cc::compound_statement *definition = nullptr,
                          bool is_redeclared = false)
-        : cc::declaration(type_specifier)
+        : cc::declaration(type_specifier, cc::syntax_type::function_declaration)
         , type_specifier_(type_specifier)
-        , identifier_(std::move(identifier))
-        , definition_(std::move(definition))
+        , identifier_(identifier.identifier())
+        , definition_(definition)
         , is_redeclared_(is_redeclared)
     {
         if (definition_)
         {
-            children_.push_back(definition_.get());
+            children_ = {&definition_, 1};
         }
     }
 
-    cc::syntax_type type() const override
+    /**
+     * @brief Creates a definition whose body was skipped. `parser` parses the body, which starts at
+     *        `body`, the first time it is asked for.
+     */
+    function_declaration(cc::token_ref type_specifier,
+                         cc::token_ref identifier,
+                         cc::token_ref body,
+                         cc::body_parser &parser,
+                         bool is_redeclared = false)
+        : function_declaration(type_specifier, identifier, nullptr, is_redeclared)
     {
-        return cc::syntax_type::function_declaration;
+        deferred_body_ = body.index();
+        body_parser_ = &parser;
     }
 
-    std::string to_string() const override
+    void describe(std::string &out) const override
     {
-        std::ostringstream ss;
-
-        const auto &pos = trigger_token().pos;
-
-        ss << "function_declaration ";
+        out += "function_declaration ";
 
         if (is_redeclared_)
         {
-            ss << "prev ";
+            out += "prev ";
         }
 
-        ss << pos.to_string("<", ">")    + " "
-            + identifier_.text           + " "
-              "'" + type_specifier_.text + " "
-              "(";
+        source_position().append_to(out, "<", ">");
+        out += ' ';
+        out += name();
+        out += " '";
+        out += type_specifier_.text();
+        out += " (";
+
+        // TODO: Add parameters to out
+
+        out += ")'";
+    }
+
+    cc::identifier_id identifier() const
+    {
+        return identifier_;
+    }
+
+    std::string_view name() const
+    {
+        return cc::identifier_table::instance().text(identifier_);
+    }
 
-        // TODO: Add parameters to ss
+    /**
+     * @brief  The body of the function, or null if it is only declared. A body that was skipped is
+     *         parsed now, and is among `children()` from then on. Not thread-safe.
+     */
+    const cc::compound_statement *definition() const
+    {
+        if (body_parser_)
+        {
+            definition_ = std::exchange(body_parser_, nullptr)->parse_body(*this);
+            children_ = {&definition_, 1};
+        }
 
-        ss << ")'";
+        return static_cast<const cc::compound_statement *>(definition_);
+    }
+
+    /**
+     * @brief Whether the function has a body, parsed or not.
+     */
+    bool is_definition() const
+    {
+        return definition_ || body_parser_;
+    }
 
-        return ss.str();
+    /**
+     * @brief Whether the body was skipped and has not been asked for yet.
+     */
+    bool is_deferred() const
+    {
+        return body_parser_ != nullptr;
     }
 
-    std::string identifier() const
+    /**
+     * @brief The '{' that starts a body which was skipped.
+     */
+    cc::token_ref deferred_body() const
     {
-        return identifier_.text;
+        return {trigger_token_.buffer(), deferred_body_};
     }
 
-    const std::unique_ptr<cc::compound_statement> &definition() const
+    bool is_redeclared() const
     {
-        return definition_;
+        return is_redeclared_;
     }
 
 private:
-    cc::token type_specifier_;
-    cc::token identifier_;
-    std::unique_ptr<cc::compound_statement> definition_;
+    cc::token_ref type_specifier_;
+    cc::identifier_id identifier_;
+    mutable cc::syntax_node *definition_;
     bool is_redeclared_;
+
+    // Only set while a skipped body has not been parsed yet
+    mutable cc::body_parser *body_parser_ = nullptr;
+    std::size_t deferred_body_ = 0;
 };
 
 } // namespace cc
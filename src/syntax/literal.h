@@ -1,95 +1,81 @@
 #ifndef C_COMPILER_LITERAL_H
 #define C_COMPILER_LITERAL_H
 
-#include "token.h"
+#include "token_buffer.h"
 #include "syntax/primary_expression.h"
 
+#include <cstdint>
+#include <string>
+
 // Not sure if this is the best way to avoid code duplication across arithmetic types, but it works
-#define DECLARE_LITERAL_SYNTAX_NODE(name, display_name)   \
-    class name : public cc::primary_expression            \
-    {                                                     \
-    public:                                               \
-        explicit name(const token &trigger_token)         \
-            : cc::primary_expression(trigger_token)       \
-        {                                                 \
-        }                                                 \
-                                                          \
-        cc::syntax_type type() const override             \
-        {                                                 \
-            return cc::syntax_type::name;                 \
-        }                                                 \
-                                                          \
-        std::string to_string() const override            \
-        {                                                 \
-            const auto &[_, text, pos] = trigger_token(); \
-                                                          \
-            return #name                       " "        \
-                   + pos.to_string("<", ">") + " "        \
-                   "'" display_name "'" " " + text;       \
-        }                                                 \
+#define DECLARE_LITERAL_SYNTAX_NODE(name, display_name, value_type, accessor)  \
+    class name : public cc::primary_expression                                 \
+    {                                                                          \
+    public:                                                                    \
+        explicit name(cc::token_ref trigger_token)                             \
+            : cc::primary_expression(trigger_token, cc::syntax_type::name)     \
+        {                                                                      \
+        }                                                                      \
+                                                                               \
+        void describe(std::string &out) const override                         \
+        {                                                                      \
+            out += #name " ";                                                  \
+            source_position().append_to(out, "<", ">");                        \
+            out += " '" display_name "' ";                                     \
+            out += trigger_token().text();                                     \
+        }                                                                      \
+                                                                               \
+        value_type value() const                                               \
+        {                                                                      \
+            return trigger_token().get().accessor();                           \
+        }                                                                      \
     }
 
 namespace cc {
 
-DECLARE_LITERAL_SYNTAX_NODE(integer_literal, "int");
-DECLARE_LITERAL_SYNTAX_NODE(double_literal, "double");
-DECLARE_LITERAL_SYNTAX_NODE(float_literal, "float");
+// The value of each literal is decoded by the lexer
+DECLARE_LITERAL_SYNTAX_NODE(integer_literal, "int", std::uint64_t, integer_value);
+DECLARE_LITERAL_SYNTAX_NODE(double_literal, "double", double, double_value);
+DECLARE_LITERAL_SYNTAX_NODE(float_literal, "float", float, float_value);
 
 // Special cases for string_literal and char_literal
 
 class string_literal : public cc::primary_expression
 {
 public:
-    explicit string_literal(const cc::token &trigger_token)
-        : cc::primary_expression(trigger_token)
-    {
-    }
-
-    cc::syntax_type type() const override
+    explicit string_literal(cc::token_ref trigger_token)
+        : cc::primary_expression(trigger_token, cc::syntax_type::string_literal)
     {
-        return cc::syntax_type::string_literal;
     }
 
-    std::string to_string() const override
+    void describe(std::string &out) const override
     {
-        std::ostringstream ss;
-
-        const auto &[_, text, pos] = trigger_token();
-
-        ss << "string_literal"             " "
-              + pos.to_string("<", ">")  + " "
-              "'char [" << text.size() << "]'"
-              " " + text;
-
-        return ss.str();
+        const auto text = trigger_token().text();
+
+        out += "string_literal ";
+        source_position().append_to(out, "<", ">");
+        out += " 'char [";
+        out += std::to_string(text.size());
+        out += "]' ";
+        out += text;
     }
 };
 
 class char_literal : public cc::primary_expression
 {
 public:
-    explicit char_literal(const cc::token &trigger_token)
-        : cc::primary_expression(trigger_token)
+    explicit char_literal(cc::token_ref trigger_token)
+        : cc::primary_expression(trigger_token, cc::syntax_type::char_literal)
     {
     }
 
-    cc::syntax_type type() const override
+    void describe(std::string &out) const override
     {
-        return cc::syntax_type::char_literal;
-    }
-
-    std::string to_string() const override
-    {
-        std::ostringstream ss;
-
-        const auto &[_, text, pos] = trigger_token();
-
         // TODO: This is a placeholder
-        ss << "char_literal"               " "
-              + pos.to_string("<", ">")  + " "
-              + text;
-
-        return ss.str();
+        out += "char_literal ";
+        source_position().append_to(out, "<", ">");
+        out += ' ';
+        out += trigger_token().text();
     }
 };
 
@@ -1,7 +1,7 @@
 #ifndef C_COMPILER_PARENTHESIZED_EXPRESSION_H
 #define C_COMPILER_PARENTHESIZED_EXPRESSION_H
 
-#include "token.h"
+#include "token_buffer.h"
 #include "syntax/expression.h"
 #include "syntax/primary_expression.h"
 #include "syntax/syntax_type.h"
@@ -11,28 +11,22 @@ namespace cc {
 class parenthesized_expression : public cc::primary_expression
 {
 public:
-    parenthesized_expression(const cc::token &trigger_token,
-                             std::unique_ptr<cc::expression> enclosed_expression)
-        : cc::primary_expression(trigger_token)
-        , enclosed_expression_(std::move(enclosed_expression))
+    parenthesized_expression(cc::token_ref trigger_token,
+                             cc::expression *enclosed_expression)
+        : cc::primary_expression(trigger_token, cc::syntax_type::parenthesized_expression)
+        , enclosed_expression_(enclosed_expression)
     {
-        children_.push_back(enclosed_expression_.get());
+        children_ = {&enclosed_expression_, 1};
     }
 
-    cc::syntax_type type() const override
+    void describe(std::string &out) const override
     {
-        return cc::syntax_type::parenthesized_expression;
-    }
-
-    std::string to_string() const override
-    {
-        const auto &pos = trigger_token().pos;
-
-        return "parenthesized_expression " + pos.to_string("<", ">");
+        out += "parenthesized_expression ";
+        source_position().append_to(out, "<", ">");
     }
 
 private:
-    std::unique_ptr<cc::expression> enclosed_expression_;
+    cc::syntax_node *enclosed_expression_;
 };
 
 } // namespace cc
@@ -1,7 +1,8 @@
 #ifndef C_COMPILER_PRIMARY_EXPRESSION_H
 #define C_COMPILER_PRIMARY_EXPRESSION_H
 
-#include "token.h"
+#include "token_buffer.h"
+#include "syntax/syntax_type.h"
 #include "syntax/expression.h"
 
 namespace cc {
@@ -17,8 +18,8 @@ public:
     primary_expression &operator=(primary_expression &&) = delete;
 
 protected:
-    explicit primary_expression(const cc::token &trigger_token)
-        : cc::expression(trigger_token)
+    primary_expression(cc::token_ref trigger_token, cc::syntax_type type)
+        : cc::expression(trigger_token, type)
     {
     }
 };
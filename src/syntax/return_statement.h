@@ -1,7 +1,7 @@
 #ifndef C_COMPILER_RETURN_STATEMENT_H
 #define C_COMPILER_RETURN_STATEMENT_H
 
-#include "token.h"
+#include "token_buffer.h"
 #include "syntax/expression.h"
 #include "syntax/statement.h"
 #include "syntax/syntax_type.h"
@@ -11,37 +11,30 @@ namespace cc {
 class return_statement : public cc::statement
 {
 public:
-    explicit return_statement(const cc::token &trigger_token,
-                              std::unique_ptr<expression> return_expression = nullptr)
-        : cc::statement(trigger_token)
-        , expression_(std::move(return_expression))
+    explicit return_statement(cc::token_ref trigger_token,
+                              cc::expression *return_expression = nullptr)
+        : cc::statement(trigger_token, cc::syntax_type::return_statement)
+        , expression_(return_expression)
     {
         if (expression_)
         {
-            children_.push_back(expression_.get());
+            children_ = {&expression_, 1};
         }
     }
 
-    cc::syntax_type type() const override
+    void describe(std::string &out) const override
     {
-        return cc::syntax_type::return_statement;
-    }
-
-    std::string to_string() const override
-    {
-        const auto &pos = trigger_token().pos;
-
-        return "return_statement"    " "
-               + pos.to_string("<", ">");
+        out += "return_statement ";
+        source_position().append_to(out, "<", ">");
     }
 
     const cc::expression *return_expression() const
     {
-        return expression_.get();
+        return static_cast<const cc::expression *>(expression_);
     }
 
 private:
-    std::unique_ptr<cc::expression> expression_;
+    cc::syntax_node *expression_;
 };
 
 } // namespace cc
@@ -1,7 +1,7 @@
 #ifndef C_COMPILER_STATEMENT_H
 #define C_COMPILER_STATEMENT_H
 
-#include "token.h"
+#include "token_buffer.h"
 #include "syntax/syntax_node.h"
 
 namespace cc {
@@ -17,8 +17,8 @@ public:
     statement &operator=(statement &&) = delete;
 
 protected:
-    explicit statement(const cc::token &trigger_token)
-        : cc::syntax_node(trigger_token)
+    statement(cc::token_ref trigger_token, cc::syntax_type type)
+        : cc::syntax_node(trigger_token, type)
     {
     }
 };
@@ -1,48 +1,87 @@
 #ifndef C_COMPILER_SYNTAX_NODE_H
 #define C_COMPILER_SYNTAX_NODE_H
 
-#include "token.h"
+#include "token_buffer.h"
 #include "syntax/syntax_type.h"
 
-#include <functional>
-#include <utility>
+#include <cstddef>
+#include <ostream>
+#include <sstream>
+#include <span>
+#include <string>
+#include <string_view>
 #include <vector>
 
 namespace cc {
 
+/**
+ * @brief The base of every node in the syntax tree. Nodes are allocated in the `arena` of the
+ *        translation unit they belong to and are never destroyed individually, so they only hold
+ *        plain pointers, spans into the arena and handles to tokens.
+ */
 class syntax_node
 {
 public:
     /**
-     * @brief  Returns the type of this node.
+     * @brief  Returns the type of this node. It is stored in the node rather than given by a
+     *         virtual function, so that passes can switch on it without an indirect call. See
+     *         `syntax_visitor`.
      * @return The type of this node.
      */
-    virtual cc::syntax_type type() const = 0;
+    cc::syntax_type type() const
+    {
+        return type_;
+    }
+
+    /**
+     * @brief Appends a description of this node to `out`, without a trailing newline.
+     */
+    virtual void describe(std::string &out) const = 0;
 
     /**
      * @brief  Constructs an std::string that describes this node.
      * @return A description of this node.
      */
-    virtual std::string to_string() const = 0;
+    std::string to_string() const
+    {
+        std::string result;
+        describe(result);
+        return result;
+    }
 
     cc::source_position source_position() const
     {
-        return trigger_token().pos;
+        return trigger_token().position();
     }
 
-    const std::vector<syntax_node *> &children() const
+    std::span<syntax_node *const> children() const
     {
         return children_;
     }
 
-    const token &trigger_token() const
+    cc::token_ref trigger_token() const
     {
         return trigger_token_;
     }
 
     /**
      * @brief Constructs an std::string that depicts this node and all its children in the form of a
-     *        pretty-printed tree.
+     *        pretty-printed tree. See `print_tree()`.
+     */
+    std::string tree_representation(std::string_view indent = {}, bool last = true, bool root = true) const
+    {
+        std::ostringstream ss;
+        print_tree(ss, indent, last, root);
+        return ss.str();
+    }
+
+    /**
+     * @brief Writes a depiction of this node and all its children in the form of a pretty-printed
+     *        tree to `out`, one line per node with no newline after the last one. The tree is walked
+     *        once, and each line is written as soon as it is formatted, so printing takes time
+     *        linear in the size of the output however deep the tree is.
+     *
+     * @param[in] out    The stream to write the tree to.
      *
      * @param[in] indent A string that determines what the indent for this node looks like.
      *
@@ -51,46 +90,66 @@ public:
      *
      * @param[in] root   Whether this node should be considered to be the root node. Affects whether
      *                   this node will be prefixed by a visual representation of a branch.
-     *
-     * @return           A visual representation of the syntax tree rooted at this node.
      */
-    virtual std::string tree_representation(std::string indent = std::string(),
-                                            bool last = true,
-                                            bool root = true) const
+    void print_tree(std::ostream &out, std::string_view indent = {}, bool last = true, bool root = true) const
     {
-        std::ostringstream ss;
+        struct frame
+        {
+            const syntax_node *node;
+            std::size_t next_child;
 
-        // Indent this node with the indent string
-        ss << indent;
+            // The length of the indent before the branch to this node was added to it
+            std::size_t indent_size;
+        };
 
-        // Only show a branch if this is not the root node
-        if (!root)
+        // The indent of the children of the node on top of the stack, shared by every line
+        auto prefix = std::string(indent);
+        auto line = std::string();
+        auto stack = std::vector<frame>();
+
+        const auto print = [&](const syntax_node &node, bool is_last, bool is_root)
         {
-            // If last out of siblings, show a terminated branch
-            if (last)
+            const auto indent_size = prefix.size();
+
+            // Every line but the first ends the one before it
+            line.clear();
+            if (!stack.empty())
             {
-                ss << "`-";
-                indent += "  ";
+                line += '\n';
             }
-            // Otherwise, show a three-way junction
-            else
+            line += prefix;
+
+            // Only show a branch if this is not the root node. If last out of siblings, show a
+            // terminated branch, otherwise a three-way junction.
+            if (!is_root)
             {
-                ss << "|-";
-                indent += "| ";
+                line += is_last ? "`-" : "|-";
+                prefix += is_last ? "  " : "| ";
             }
-        }
 
-        // Add this node's description
-        ss << to_string();
+            node.describe(line);
+            out.write(line.data(), static_cast<std::streamsize>(line.size()));
+
+            stack.push_back({&node, 0, indent_size});
+        };
+
+        print(*this, last, root);
 
-        // Add each child tree
-        for (std::size_t i = 0; i < children_.size(); i++)
+        while (!stack.empty())
         {
-            ss << '\n';
-            ss << children_[i]->tree_representation(indent, i == children_.size() - 1, false);
-        }
+            auto &top = stack.back();
+            const auto children = top.node->children_;
 
-        return ss.str();
+            if (top.next_child == children.size())
+            {
+                prefix.resize(top.indent_size);
+                stack.pop_back();
+                continue;
+            }
+
+            const auto i = top.next_child++;
+            print(*children[i], i == children.size() - 1, false);
+        }
     }
 
     virtual ~syntax_node() = default;
@@ -101,14 +160,19 @@ public:
     syntax_node &operator=(syntax_node &&) = delete;
 
 protected:
-    explicit syntax_node(cc::token trigger_token)
-        : trigger_token_(std::move(trigger_token))
+    syntax_node(cc::token_ref trigger_token, cc::syntax_type type)
+        : trigger_token_(trigger_token)
+        , type_(type)
     {
     }
 
 protected:
-    std::vector<syntax_node *> children_;
-    cc::token trigger_token_;
+    // Mutable so that a child which is only parsed once it is asked for can be attached
+    mutable std::span<syntax_node *const> children_;
+    cc::token_ref trigger_token_;
+
+private:
+    cc::syntax_type type_;
 };
 
 } // namespace cc
@@ -1,9 +1,12 @@
 #ifndef C_COMPILER_SYNTAX_TYPE_H
 #define C_COMPILER_SYNTAX_TYPE_H
 
+#include <cstdint>
+
 namespace cc {
 
-enum class syntax_type
+// Stored as a single byte, so flat syntax trees stay small
+enum class syntax_type : std::uint8_t
 {
     integer_literal = 0,
     double_literal,
@@ -18,6 +21,7 @@ enum class syntax_type
     return_statement,
     compound_statement,
     translation_unit_declaration,
+    error,
 };
 
 } // namespace cc
@@ -0,0 +1,269 @@
+#ifndef C_COMPILER_SYNTAX_VISITOR_H
+#define C_COMPILER_SYNTAX_VISITOR_H
+
+#include "syntax/binary_expression.h"
+#include "syntax/compound_statement.h"
+#include "syntax/declaration_reference_expression.h"
+#include "syntax/error_node.h"
+#include "syntax/function_declaration.h"
+#include "syntax/literal.h"
+#include "syntax/parenthesized_expression.h"
+#include "syntax/return_statement.h"
+#include "syntax/syntax_node.h"
+#include "syntax/syntax_type.h"
+#include "syntax/translation_unit_declaration.h"
+#include "syntax/variable_declaration.h"
+
+#include <cstddef>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace cc {
+
+/**
+ * @brief The concrete node classes, in the order of their `cc::syntax_type`.
+ */
+using syntax_classes = std::tuple<cc::integer_literal,
+                                  cc::double_literal,
+                                  cc::float_literal,
+                                  cc::string_literal,
+                                  cc::char_literal,
+                                  cc::binary_expression,
+                                  cc::parenthesized_expression,
+                                  cc::declaration_reference_expression,
+                                  cc::variable_declaration,
+                                  cc::function_declaration,
+                                  cc::return_statement,
+                                  cc::compound_statement,
+                                  cc::translation_unit_declaration,
+                                  cc::error_node>;
+
+static_assert(std::tuple_size_v<cc::syntax_classes> == static_cast<std::size_t>(cc::syntax_type::error) + 1);
+
+/**
+ * @brief  Calls `f` with `node` cast to its concrete class, which is found by switching on its type.
+ * @return What `f` returns, which must be the same type for every class.
+ */
+template<typename F>
+decltype(auto) dispatch(const cc::syntax_node &node, F &&f)
+{
+    switch (node.type())
+    {
+    case cc::syntax_type::integer_literal:
+        return f(static_cast<const cc::integer_literal &>(node));
+    case cc::syntax_type::double_literal:
+        return f(static_cast<const cc::double_literal &>(node));
+    case cc::syntax_type::float_literal:
+        return f(static_cast<const cc::float_literal &>(node));
+    case cc::syntax_type::string_literal:
+        return f(static_cast<const cc::string_literal &>(node));
+    case cc::syntax_type::char_literal:
+        return f(static_cast<const cc::char_literal &>(node));
+    case cc::syntax_type::binary_expression:
+        return f(static_cast<const cc::binary_expression &>(node));
+    case cc::syntax_type::parenthesized_expression:
+        return f(static_cast<const cc::parenthesized_expression &>(node));
+    case cc::syntax_type::declaration_reference_expression:
+        return f(static_cast<const cc::declaration_reference_expression &>(node));
+    case cc::syntax_type::variable_declaration:
+        return f(static_cast<const cc::variable_declaration &>(node));
+    case cc::syntax_type::function_declaration:
+        return f(static_cast<const cc::function_declaration &>(node));
+    case cc::syntax_type::return_statement:
+        return f(static_cast<const cc::return_statement &>(node));
+    case cc::syntax_type::compound_statement:
+        return f(static_cast<const cc::compound_statement &>(node));
+    case cc::syntax_type::translation_unit_declaration:
+        return f(static_cast<const cc::translation_unit_declaration &>(node));
+    case cc::syntax_type::error:
+        return f(static_cast<const cc::error_node &>(node));
+    }
+
+    throw std::runtime_error("Unexpected node in syntax tree");
+}
+
+/**
+ * @brief The base of a pass over a class tree whose callbacks are bound at compile time, so that
+ *        they can be inlined into the traversal.
+ *
+ *        `Derived` has public `enter()` callbacks, which are called on a node before its children,
+ *        and `leave()` callbacks, which are called after them, overloaded on the node classes it
+ *        handles:
+ *
+ *            bool enter(const cc::compound_statement &node);
+ *            void leave(const cc::expression &node);
+ *
+ *        A callback that takes a base class such as `cc::expression` handles every class derived
+ *        from it that has no callback of its own. Nodes that no callback takes are walked through.
+ *        If `enter()` returns false, the children of the node are skipped, but it is still left.
+ *
+ *        The tree is walked with an explicit stack, so a pass works on trees of any depth. Bodies
+ *        that `parse_declarations()` skipped are not parsed by the walk, only walked once they have
+ *        been asked for.
+ */
+template<typename Derived>
+class syntax_visitor
+{
+public:
+    /**
+     * @brief Walks the tree rooted at `root`, calling the callbacks in pre- and post-order.
+     */
+    void traverse(const cc::syntax_node &root)
+    {
+        stack_.clear();
+        push_or_leave(root, enter_node(root));
+
+        while (!stack_.empty())
+        {
+            // Most children are leaves, which are entered and left right away, so the position among
+            // the children of the top node is kept aside until a child has to be pushed
+            auto &top = stack_.back();
+            auto next_child = top.next_child;
+            const auto end = top.end;
+            auto pushed = false;
+
+            while (next_child != end && !pushed)
+            {
+                const auto &child = **next_child++;
+                const auto descend = enter_node(child);
+
+                top.next_child = next_child;
+                pushed = push_or_leave(child, descend);
+            }
+
+            if (!pushed)
+            {
+                const auto &node = *stack_.back().node;
+                stack_.pop_back();
+                leave_node(node);
+            }
+        }
+    }
+
+protected:
+    syntax_visitor() = default;
+    ~syntax_visitor() = default;
+
+private:
+    struct frame
+    {
+        const cc::syntax_node *node;
+        cc::syntax_node *const *next_child;
+        cc::syntax_node *const *end;
+    };
+
+    static constexpr auto class_indices = std::make_index_sequence<std::tuple_size_v<cc::syntax_classes>>();
+
+    template<std::size_t I>
+    using class_at = std::tuple_element_t<I, cc::syntax_classes>;
+
+    Derived &derived()
+    {
+        return static_cast<Derived &>(*this);
+    }
+
+    /**
+     * @brief  Pushes an entered node to walk its children, or leaves it if it has none or they are
+     *         to be skipped.
+     * @return Whether the node was pushed.
+     */
+    bool push_or_leave(const cc::syntax_node &node, bool descend)
+    {
+        // Entering may have parsed a body that was skipped, so the children are only looked at now
+        const auto children = node.children();
+
+        if (descend && !children.empty())
+        {
+            stack_.push_back({&node, children.data(), children.data() + children.size()});
+            return true;
+        }
+
+        leave_node(node);
+        return false;
+    }
+
+    // Rather than a full `cc::dispatch()`, the type is only compared against the classes that the
+    // pass has a callback for. The classes without one share a single way out, so the comparisons
+    // become a bit test or a short chain instead of an indirect jump per node.
+
+    bool enter_node(const cc::syntax_node &node)
+    {
+        auto descend = true;
+
+        [&]<std::size_t... I>(std::index_sequence<I...>) {
+            static_cast<void>((enter_if<I>(node, descend) || ...));
+        }(class_indices);
+
+        return descend;
+    }
+
+    void leave_node(const cc::syntax_node &node)
+    {
+        [&]<std::size_t... I>(std::index_sequence<I...>) {
+            static_cast<void>((leave_if<I>(node) || ...));
+        }(class_indices);
+    }
+
+    /**
+     * @brief  Calls the `enter()` callback for the `I`th class if `node` is one and there is one.
+     * @return Whether it was called.
+     */
+    template<std::size_t I>
+    bool enter_if(const cc::syntax_node &node, bool &descend)
+    {
+        using concrete_class = class_at<I>;
+
+        if constexpr (requires(const concrete_class &concrete) { derived().enter(concrete); })
+        {
+            if (node.type() == static_cast<cc::syntax_type>(I))
+            {
+                const auto &concrete = static_cast<const concrete_class &>(node);
+
+                if constexpr (std::is_void_v<decltype(derived().enter(concrete))>)
+                {
+                    derived().enter(concrete);
+                }
+                else
+                {
+                    descend = derived().enter(concrete);
+                }
+
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief  Calls the `leave()` callback for the `I`th class if `node` is one and there is one.
+     * @return Whether it was called.
+     */
+    template<std::size_t I>
+    bool leave_if(const cc::syntax_node &node)
+    {
+        using concrete_class = class_at<I>;
+
+        if constexpr (requires(const concrete_class &concrete) { derived().leave(concrete); })
+        {
+            if (node.type() == static_cast<cc::syntax_type>(I))
+            {
+                derived().leave(static_cast<const concrete_class &>(node));
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+private:
+    // The nodes whose children are being walked, innermost last. Kept to reuse its storage.
+    std::vector<frame> stack_;
+};
+
+} // namespace cc
+
+#endif
@@ -1,41 +1,49 @@
 #ifndef C_COMPILER_TRANSLATION_UNIT_H
 #define C_COMPILER_TRANSLATION_UNIT_H
 
-#include "token.h"
+#include "arena.h"
+#include "token_buffer.h"
 #include "syntax/declaration.h"
 #include "syntax/syntax_node.h"
 #include "syntax/syntax_type.h"
 
 #include <memory>
+#include <span>
+#include <utility>
 
 namespace cc {
 
+/**
+ * @brief The root of a syntax tree. It owns the arena that every other node in the tree was
+ *        allocated from, so the whole tree is released with it in one step.
+ */
 class translation_unit_declaration : public cc::syntax_node
 {
 public:
-    translation_unit_declaration(const cc::token &trigger_token,
-                                 std::vector<std::unique_ptr<cc::declaration>> declarations)
-        : cc::syntax_node(trigger_token)
-        , declarations_(std::move(declarations))
+    /**
+     * @param[in] declarations The top-level declarations, in an array allocated from `nodes`.
+     * @param[in] nodes        The arena the rest of the tree was allocated from.
+     * @param[in] tokens       Tokens that nodes refer to, if they are not kept elsewhere.
+     */
+    translation_unit_declaration(cc::token_ref trigger_token,
+                                 std::span<cc::syntax_node *const> declarations,
+                                 cc::arena nodes,
+                                 std::unique_ptr<cc::token_buffer> tokens = nullptr)
+        : cc::syntax_node(trigger_token, cc::syntax_type::translation_unit_declaration)
+        , nodes_(std::move(nodes))
+        , tokens_(std::move(tokens))
     {
-        for (const auto &decl : declarations_)
-        {
-            children_.push_back(decl.get());
-        }
+        children_ = declarations;
     }
 
-    cc::syntax_type type() const override
+    void describe(std::string &out) const override
     {
-        return cc::syntax_type::translation_unit_declaration;
-    }
-
-    std::string to_string() const override
-    {
-        return "translation_unit_declaration";
+        out += "translation_unit_declaration";
     }
 
 private:
-    std::vector<std::unique_ptr<cc::declaration>> declarations_;
+    cc::arena nodes_;
+    std::unique_ptr<cc::token_buffer> tokens_;
 };
 
 } // namespace cc
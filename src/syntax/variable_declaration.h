@@ -1,60 +1,61 @@
 #ifndef C_COMPILER_VARIABLE_DECLARATION_H
 #define C_COMPILER_VARIABLE_DECLARATION_H
 
-#include "token.h"
+#include "identifier_table.h"
+#include "token_buffer.h"
 #include "syntax/declaration.h"
 #include "syntax/expression.h"
 #include "syntax/syntax_type.h"
 
-#include <utility>
-
 namespace cc {
 
 class variable_declaration : public cc::declaration
 {
 public:
-    variable_declaration(const cc::token &type_specifier,
-                         cc::token identifier,
-                         std::unique_ptr<cc::expression> initializer = nullptr)
-        : cc::declaration(type_specifier)
+    variable_declaration(cc::token_ref type_specifier,
+                         cc::token_ref identifier,
+                         cc::expression *initializer = nullptr)
+        : cc::declaration(type_specifier, cc::syntax_type::variable_declaration)
         , type_specifier_(type_specifier)
-        , identifier_(std::move(identifier))
-        , initializer_(std::move(initializer))
+        , identifier_(identifier.identifier())
+        , initializer_(initializer)
     {
         if (initializer_)
         {
-            children_.push_back(initializer_.get());
+            children_ = {&initializer_, 1};
         }
     }
 
-    cc::syntax_type type() const override
-    {
-        return cc::syntax_type::variable_declaration;
-    }
-
-    std::string to_string() const override
+    void describe(std::string &out) const override
     {
-        std::ostringstream ss;
-
-        const auto &pos = trigger_token().pos;
-
-        ss << "variable_declaration"         " "
-              + pos.to_string("<", ">")    + " "
-              + identifier_.text           + " "
-                "'" + type_specifier_.text + "'";
+        out += "variable_declaration ";
+        source_position().append_to(out, "<", ">");
+        out += ' ';
+        out += name();
+        out += " '";
+        out += type_specifier_.text();
+        out += '\'';
 
         if (initializer_)
         {
-            ss << " cinit";
+            out += " cinit";
         }
+    }
 
-        return ss.str();
+    cc::identifier_id identifier() const
+    {
+        return identifier_;
+    }
+
+    std::string_view name() const
+    {
+        return cc::identifier_table::instance().text(identifier_);
     }
 
 private:
-    cc::token type_specifier_;
-    cc::token identifier_;
-    std::unique_ptr<cc::expression> initializer_;
+    cc::token_ref type_specifier_;
+    cc::identifier_id identifier_;
+    cc::syntax_node *initializer_;
 };
 
 } // namespace cc
@@ -0,0 +1,189 @@
+#ifndef C_COMPILER_SYNTAX_TREE_BUILDER_H
+#define C_COMPILER_SYNTAX_TREE_BUILDER_H
+
+#include "arena.h"
+#include "token_buffer.h"
+#include "token_type.h"
+#include "syntax/binary_expression.h"
+#include "syntax/compound_statement.h"
+#include "syntax/declaration_reference_expression.h"
+#include "syntax/error_node.h"
+#include "syntax/function_declaration.h"
+#include "syntax/literal.h"
+#include "syntax/parenthesized_expression.h"
+#include "syntax/return_statement.h"
+#include "syntax/syntax_node.h"
+#include "syntax/syntax_type.h"
+#include "syntax/translation_unit_declaration.h"
+#include "syntax/variable_declaration.h"
+
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+namespace cc {
+
+/**
+ * @brief Builds a tree of `syntax_node` objects for the parser. Every node is allocated from an
+ *        arena that the root takes over.
+ *
+ *        A tree builder turns what the parser recognized into nodes. Nodes are passed around as
+ *        opaque handles of type `node`, and children are always built before their parent. The
+ *        parser relies on the grammar to only ever pass a node where the matching kind of node is
+ *        expected.
+ */
+class syntax_tree_builder
+{
+public:
+    using node = cc::syntax_node *;
+    using result = std::unique_ptr<cc::syntax_node>;
+
+    static constexpr node none = nullptr;
+
+    node literal(cc::token_ref token)
+    {
+        switch (token.type())
+        {
+        case cc::token_type::char_literal:
+            return nodes_.create<cc::char_literal>(token);
+        case cc::token_type::integer_literal:
+            return nodes_.create<cc::integer_literal>(token);
+        case cc::token_type::double_literal:
+            return nodes_.create<cc::double_literal>(token);
+        case cc::token_type::float_literal:
+            return nodes_.create<cc::float_literal>(token);
+        case cc::token_type::string_literal:
+            return nodes_.create<cc::string_literal>(token);
+        default:
+            throw std::runtime_error("Hit unreachable branch in syntax_tree_builder::literal()");
+        }
+    }
+
+    node parenthesized_expression(cc::token_ref open, node expression)
+    {
+        return nodes_.create<cc::parenthesized_expression>(open, as<cc::expression>(expression));
+    }
+
+    node declaration_reference_expression(cc::token_ref identifier)
+    {
+        return nodes_.create<cc::declaration_reference_expression>(identifier);
+    }
+
+    node binary_expression(cc::token_ref op, node left, node right)
+    {
+        return nodes_.create<cc::binary_expression>(op, as<cc::expression>(left), as<cc::expression>(right));
+    }
+
+    /**
+     * @brief Makes a declaration reference expression refer to a variable or function declaration.
+     *        A reference may be built before the declaration it refers to is complete, so it is
+     *        resolved separately.
+     */
+    void resolve(node reference, node declaration)
+    {
+        as<cc::declaration_reference_expression>(reference)->resolve(*as<cc::declaration>(declaration));
+    }
+
+    node return_statement(cc::token_ref keyword, node expression)
+    {
+        return nodes_.create<cc::return_statement>(keyword, as<cc::expression>(expression));
+    }
+
+    node compound_statement(cc::token_ref open, std::span<const node> statements, bool returns)
+    {
+        auto *block = nodes_.create<cc::compound_statement>(open, nodes_.copy(statements));
+        block->has_return(returns);
+        return block;
+    }
+
+    node variable_declaration(cc::token_ref type_specifier, cc::token_ref identifier, node initializer)
+    {
+        return nodes_.create<cc::variable_declaration>(type_specifier, identifier, as<cc::expression>(initializer));
+    }
+
+    node function_declaration(cc::token_ref type_specifier, cc::token_ref identifier, node definition, bool is_redeclared)
+    {
+        return nodes_.create<cc::function_declaration>(type_specifier, identifier, as<cc::compound_statement>(definition),
+                                                       is_redeclared);
+    }
+
+    /**
+     * @brief A function definition whose body, which starts at `body`, was skipped. `parser` parses
+     *        the body once it is asked for.
+     */
+    node deferred_function_declaration(cc::token_ref type_specifier,
+                                       cc::token_ref identifier,
+                                       cc::token_ref body,
+                                       bool is_redeclared,
+                                       cc::body_parser &parser)
+    {
+        return nodes_.create<cc::function_declaration>(type_specifier, identifier, body, parser, is_redeclared);
+    }
+
+    node error(cc::token_ref token)
+    {
+        return nodes_.create<cc::error_node>(token);
+    }
+
+    /**
+     * @brief  Takes over a subtree that was built by another builder, with the tokens of the same
+     *         buffer. Subtrees must be adopted in the order `other` built them.
+     * @return The root of the subtree in this builder.
+     */
+    node adopt(syntax_tree_builder &other, node root)
+    {
+        // The first subtree adopted from `other` brings all of its nodes along
+        nodes_.absorb(std::move(other.nodes_));
+        return root;
+    }
+
+    /**
+     * @brief  Where a node of the subtree that was adopted last ended up in this builder.
+     */
+    node adopted(node n) const
+    {
+        return n;
+    }
+
+    /**
+     * @brief  Builds the root, which takes over everything built so far. Nodes built afterwards
+     *         are allocated anew and stay with the builder.
+     *
+     * @param[in] tokens Tokens that nodes refer to, if they are not kept elsewhere.
+     */
+    result translation_unit(cc::token_ref first,
+                            std::span<const node> declarations,
+                            std::unique_ptr<cc::token_buffer> tokens = nullptr)
+    {
+        const auto children = nodes_.copy(declarations);
+        return std::make_unique<cc::translation_unit_declaration>(first, children, std::move(nodes_), std::move(tokens));
+    }
+
+    cc::syntax_type kind(node n) const
+    {
+        return n->type();
+    }
+
+    /**
+     * @brief  Whether a compound statement contains a return statement.
+     */
+    bool returns(node n) const
+    {
+        return static_cast<const cc::compound_statement *>(n)->returns();
+    }
+
+private:
+    template<typename T>
+    static T *as(node n)
+    {
+        return static_cast<T *>(n);
+    }
+
+private:
+    cc::arena nodes_;
+};
+
+} // namespace cc
+
+#endif
@@ -1,39 +1,56 @@
 #ifndef C_COMPILER_TOKEN_H
 #define C_COMPILER_TOKEN_H
 
+#include "identifier_table.h"
+#include "source_manager.h"
 #include "token_type.h"
 
-#include <cstddef>
-#include <sstream>
-#include <string>
+#include <bit>
+#include <cstdint>
+#include <string_view>
 
 namespace cc {
 
-struct source_position
+struct token
 {
-    std::size_t line;
-    std::size_t column;
+    cc::token_type type;
+
+    // The interned id of an identifier token, or `invalid_identifier` for any other token
+    cc::identifier_id identifier = cc::invalid_identifier;
+
+    std::string_view text;
+    cc::source_location location;
+
+    // The binary value of a numeric literal, decoded by the lexer. Use the typed accessors below.
+    std::uint64_t value = 0;
 
-    std::string to_string(const std::string &open = "(", const std::string &close = ")") const
+    std::uint64_t integer_value() const
     {
-        std::ostringstream ss;
-        ss << open << line << "," << column << close;
-        return ss.str();
+        return value;
     }
-};
 
-struct token
-{
-    cc::token_type type;
-    std::string text;
-    cc::source_position pos;
+    double double_value() const
+    {
+        return std::bit_cast<double>(value);
+    }
+
+    float float_value() const
+    {
+        return std::bit_cast<float>(static_cast<std::uint32_t>(value));
+    }
+
+    /**
+     * @brief  Resolves the location of this token into a line and column.
+     * @return The position of the first char of this token.
+     */
+    cc::source_position position() const
+    {
+        return cc::source_manager::instance().position(location);
+    }
+
+    bool operator==(const token &) const = default;
 };
 
 } // namespace cc
 
-inline std::ostream &operator<<(std::ostream &os, cc::source_position pos)
-{
-    return os << pos.to_string();
-}
-
 #endif
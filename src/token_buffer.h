@@ -0,0 +1,429 @@
+#ifndef C_COMPILER_TOKEN_BUFFER_H
+#define C_COMPILER_TOKEN_BUFFER_H
+
+#include "identifier_table.h"
+#include "source_manager.h"
+#include "token.h"
+#include "token_type.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace cc {
+
+class token_buffer;
+
+/**
+ * @brief A lightweight handle to a token stored in a `token_buffer`. Each field is fetched from the
+ *        buffer on demand, so a handle stays small no matter how it is used.
+ */
+class token_ref
+{
+public:
+    token_ref(const cc::token_buffer &buffer, std::size_t index)
+        : buffer_(&buffer)
+        , index_(index)
+    {
+    }
+
+    std::size_t index() const
+    {
+        return index_;
+    }
+
+    const cc::token_buffer &buffer() const
+    {
+        return *buffer_;
+    }
+
+    cc::token_type type() const;
+    cc::identifier_id identifier() const;
+    std::uint64_t value() const;
+    std::string_view text() const;
+    cc::source_location location() const;
+
+    cc::source_position position() const
+    {
+        return cc::source_manager::instance().position(location());
+    }
+
+    /**
+     * @brief  Copies the token out of the buffer.
+     */
+    cc::token get() const;
+
+private:
+    const cc::token_buffer *buffer_;
+    std::size_t index_;
+};
+
+/**
+ * @brief Structure-of-arrays token storage. Types, offsets, lengths and payloads live in separate
+ *        dense arrays, so scans that only look at token types touch a single byte per token.
+ *
+ *        Token text is not stored; it is recovered from the source file by offset and length. The
+ *        only exception is literals whose text was decoded by the lexer, which are kept in a small
+ *        side table. All tokens in a buffer belong to the same file.
+ *
+ *        The payload of an identifier is its id. The payload of a numeric literal is the index of
+ *        its value in a separate array, so tokens without a value take no space for one.
+ */
+class token_buffer
+{
+public:
+    explicit token_buffer(cc::file_id file)
+        : file_(file)
+        , source_(cc::source_manager::instance().file(file).text())
+    {
+    }
+
+    /**
+     * @brief Iterates over the buffer by value, so a `token_buffer` can be used anywhere a range of
+     *        `cc::token` is expected.
+     */
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = cc::token;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = cc::token;
+
+        const_iterator() = default;
+
+        const_iterator(const cc::token_buffer &buffer, std::size_t index)
+            : buffer_(&buffer)
+            , index_(index)
+        {
+        }
+
+        cc::token operator*() const
+        {
+            return buffer_->get(index_);
+        }
+
+        const_iterator &operator++()
+        {
+            index_++;
+            return *this;
+        }
+
+        const_iterator operator++(int)
+        {
+            auto previous = *this;
+            index_++;
+            return previous;
+        }
+
+        bool operator==(const const_iterator &other) const
+        {
+            return index_ == other.index_;
+        }
+
+    private:
+        const cc::token_buffer *buffer_ = nullptr;
+        std::size_t index_ = 0;
+    };
+
+    cc::file_id file() const
+    {
+        return file_;
+    }
+
+    std::size_t size() const
+    {
+        return types_.size();
+    }
+
+    bool empty() const
+    {
+        return types_.empty();
+    }
+
+    void reserve(std::size_t count)
+    {
+        types_.reserve(count);
+        offsets_.reserve(count);
+        lengths_.reserve(count);
+        payloads_.reserve(count);
+    }
+
+    /**
+     * @brief Appends a token. The token must come from this buffer's file.
+     */
+    void push_back(const cc::token &token)
+    {
+        const auto offset = token.location.offset;
+        const auto length = static_cast<std::uint32_t>(token.text.size());
+
+        if (token.text.data() != source_.data() + offset)
+        {
+            decoded_.emplace_back(static_cast<std::uint32_t>(types_.size()), token.text);
+        }
+
+        types_.push_back(static_cast<std::uint8_t>(token.type));
+        offsets_.push_back(offset);
+        lengths_.push_back(length);
+
+        if (is_numeric_literal(token.type))
+        {
+            payloads_.push_back(static_cast<std::uint32_t>(values_.size()));
+            values_.push_back(token.value);
+        }
+        else
+        {
+            payloads_.push_back(token.identifier);
+        }
+    }
+
+    /**
+     * @brief Appends the first `count` tokens of `other`, which must belong to the same file.
+     */
+    void append(const token_buffer &other, std::size_t count)
+    {
+        const auto first_index = static_cast<std::uint32_t>(types_.size());
+        const auto difference = static_cast<std::ptrdiff_t>(count);
+
+        types_.insert(types_.end(), other.types_.begin(), other.types_.begin() + difference);
+        offsets_.insert(offsets_.end(), other.offsets_.begin(), other.offsets_.begin() + difference);
+        lengths_.insert(lengths_.end(), other.lengths_.begin(), other.lengths_.begin() + difference);
+
+        const auto first_value = static_cast<std::uint32_t>(values_.size());
+        std::size_t value_count = 0;
+        for (std::size_t i = 0; i < count; i++)
+        {
+            if (is_numeric_literal(other.type(i)))
+            {
+                payloads_.push_back(first_value + other.payloads_[i]);
+                value_count++;
+            }
+            else
+            {
+                payloads_.push_back(other.payloads_[i]);
+            }
+        }
+        values_.insert(values_.end(), other.values_.begin(), other.values_.begin() + static_cast<std::ptrdiff_t>(value_count));
+
+        for (const auto &[index, text] : other.decoded_)
+        {
+            if (index >= count)
+            {
+                break;
+            }
+            decoded_.emplace_back(first_index + index, text);
+        }
+    }
+
+    /**
+     * @brief Removes the first `count` tokens. Indices of the remaining tokens shift down by
+     *        `count`.
+     */
+    void erase_front(std::size_t count)
+    {
+        const auto difference = static_cast<std::ptrdiff_t>(count);
+
+        const auto erased_values = static_cast<std::uint32_t>(std::count_if(types_.begin(), types_.begin() + difference, [](std::uint8_t type) {
+            return is_numeric_literal(static_cast<cc::token_type>(type));
+        }));
+        values_.erase(values_.begin(), values_.begin() + erased_values);
+
+        types_.erase(types_.begin(), types_.begin() + difference);
+        offsets_.erase(offsets_.begin(), offsets_.begin() + difference);
+        lengths_.erase(lengths_.begin(), lengths_.begin() + difference);
+        payloads_.erase(payloads_.begin(), payloads_.begin() + difference);
+
+        for (std::size_t i = 0; i < payloads_.size(); i++)
+        {
+            if (is_numeric_literal(type(i)))
+            {
+                payloads_[i] -= erased_values;
+            }
+        }
+
+        const auto kept = std::lower_bound(decoded_.begin(), decoded_.end(), count, [](const auto &entry, std::size_t index) {
+            return entry.first < index;
+        });
+        decoded_.erase(decoded_.begin(), kept);
+        for (auto &entry : decoded_)
+        {
+            entry.first -= static_cast<std::uint32_t>(count);
+        }
+    }
+
+    void clear()
+    {
+        types_.clear();
+        offsets_.clear();
+        lengths_.clear();
+        payloads_.clear();
+        values_.clear();
+        decoded_.clear();
+    }
+
+    /**
+     * @brief Replaces every identifier id `id` with `identifier_map[id]`. Used to move tokens
+     *        that were interned into one `identifier_table` over to another.
+     */
+    void remap_identifiers(const std::vector<cc::identifier_id> &identifier_map)
+    {
+        for (std::size_t i = 0; i < payloads_.size(); i++)
+        {
+            if (type(i) == cc::token_type::identifier)
+            {
+                payloads_[i] = identifier_map[payloads_[i]];
+            }
+        }
+    }
+
+    cc::token_type type(std::size_t index) const
+    {
+        return static_cast<cc::token_type>(types_[index]);
+    }
+
+    /**
+     * @brief  The dense array of token types, one byte per token.
+     */
+    const std::vector<std::uint8_t> &types() const
+    {
+        return types_;
+    }
+
+    std::uint32_t offset(std::size_t index) const
+    {
+        return offsets_[index];
+    }
+
+    std::uint32_t length(std::size_t index) const
+    {
+        return lengths_[index];
+    }
+
+    cc::identifier_id identifier(std::size_t index) const
+    {
+        return type(index) == cc::token_type::identifier ? payloads_[index] : cc::invalid_identifier;
+    }
+
+    /**
+     * @brief  The bit pattern of the value of a numeric literal, as in `cc::token::value`.
+     */
+    std::uint64_t value(std::size_t index) const
+    {
+        return is_numeric_literal(type(index)) ? values_[payloads_[index]] : 0;
+    }
+
+    std::string_view text(std::size_t index) const
+    {
+        if (!decoded_.empty() && can_be_decoded(type(index)))
+        {
+            const auto entry = std::lower_bound(decoded_.begin(), decoded_.end(), index, [](const auto &e, std::size_t i) {
+                return e.first < i;
+            });
+            if (entry != decoded_.end() && entry->first == index)
+            {
+                return entry->second;
+            }
+        }
+
+        return source_.substr(offsets_[index], lengths_[index]);
+    }
+
+    cc::source_location location(std::size_t index) const
+    {
+        return {offsets_[index], file_};
+    }
+
+    cc::token get(std::size_t index) const
+    {
+        return {
+            .type       = type(index),
+            .identifier = identifier(index),
+            .text       = text(index),
+            .location   = location(index),
+            .value      = value(index),
+        };
+    }
+
+    cc::token_ref operator[](std::size_t index) const
+    {
+        return {*this, index};
+    }
+
+    const_iterator begin() const
+    {
+        return {*this, 0};
+    }
+
+    const_iterator end() const
+    {
+        return {*this, size()};
+    }
+
+    /**
+     * @brief  Whether tokens of `type` may have text that differs from their source text. Only the
+     *         text of such tokens is looked up in the side table.
+     */
+    static constexpr bool can_be_decoded(cc::token_type type)
+    {
+        return type == cc::token_type::string_literal || type == cc::token_type::unknown;
+    }
+
+private:
+    static constexpr bool is_numeric_literal(cc::token_type type)
+    {
+        return type == cc::token_type::integer_literal || type == cc::token_type::double_literal ||
+               type == cc::token_type::float_literal;
+    }
+
+private:
+    cc::file_id file_;
+    std::string_view source_;
+
+    std::vector<std::uint8_t> types_;
+    std::vector<std::uint32_t> offsets_;
+    std::vector<std::uint32_t> lengths_;
+    std::vector<std::uint32_t> payloads_;
+    std::vector<std::uint64_t> values_;
+
+    // Tokens whose text does not appear verbatim in the source, sorted by token index
+    std::vector<std::pair<std::uint32_t, std::string_view>> decoded_;
+};
+
+} // namespace cc
+
+inline cc::token_type cc::token_ref::type() const
+{
+    return buffer_->type(index_);
+}
+
+inline cc::identifier_id cc::token_ref::identifier() const
+{
+    return buffer_->identifier(index_);
+}
+
+inline std::uint64_t cc::token_ref::value() const
+{
+    return buffer_->value(index_);
+}
+
+inline std::string_view cc::token_ref::text() const
+{
+    return buffer_->text(index_);
+}
+
+inline cc::source_location cc::token_ref::location() const
+{
+    return buffer_->location(index_);
+}
+
+inline cc::token cc::token_ref::get() const
+{
+    return buffer_->get(index_);
+}
+
+#endif
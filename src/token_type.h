@@ -1,12 +1,13 @@
 #ifndef C_COMPILER_TOKEN_TYPE_H
 #define C_COMPILER_TOKEN_TYPE_H
 
+#include <cstdint>
 #include <iostream>
-#include <type_traits>
 
 namespace cc {
 
-enum class token_type
+// Stored as a single byte, so dense arrays of token types stay small
+enum class token_type : std::uint8_t
 {
     integer_literal = 0,
     double_literal,
@@ -88,7 +89,7 @@ enum class token_type
 
 inline std::ostream &operator<<(std::ostream &os, cc::token_type type)
 {
-    return os << static_cast<std::underlying_type_t<cc::token_type>>(type);
+    return os << static_cast<int>(type);
 }
 
 #endif
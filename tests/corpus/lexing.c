@@ -0,0 +1,36 @@
+/* Every kind of token the lexer knows, and the places where tokens can run on */
+
+// Keywords
+char int double float struct enum void short long const static
+if else for while break continue return
+
+// Identifiers that start with or contain keywords
+integer returned _if while_1 __func__ x0 iffy
+
+// Punctuators, spaced and packed together
++ - * / % = += -= *= /= %= ++ -- | & ~ ^ << >> || && ! == != > < ( ) { } [ ] , ;
+a+=b-=c*=d/=e%=f++--g<<h>>i||j&&k==l!=m
+x = a+++b---c;
+
+// Numbers
+0 7 42 0755 1234567890 18446744073709551615
+1.0 .5 3. 1e10 1E+5 2.5e-3 6.02e23 1.5f 0.0f 3e2f 1.F
+12abc 1.2.3 1e 1e+ 0x1F
+
+/* A comment
+   that spans lines */ int after_comment;
+/**/ int empty_comment; /* unterminated at the end? no */
+
+// A line comment that is continued \
+   onto the next line
+int after_continued_comment;
+
+// Strings
+"" "plain" "with \"escapes\" \\ \n \t" "continued \
+onto the next line" "adjacent""strings"
+
+// Things that are not tokens
+'c' '\n' @ $ ` #include <header.h>
+
+int trailing = 1;
+"unterminated
@@ -0,0 +1,23 @@
+int counter = 0;
+int limit = 100;
+int scale = 2.5;
+int ratio = 1.5f;
+
+int square();
+int square();
+
+int square()
+{
+    int value = (counter + 3) * limit;
+    {
+        int limit = value / 2;
+        return limit / 7;
+    }
+    return value - counter;
+}
+
+int main()
+{
+    int result = scale + limit * (counter - 1);
+    return result;
+}
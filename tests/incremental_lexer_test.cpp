@@ -0,0 +1,93 @@
+#include "incremental_lexer.h"
+#include "lexer.h"
+#include "source_manager.h"
+#include "test_corpus.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace {
+
+constexpr std::size_t edits_per_source = 50;
+
+/**
+ * @brief  Replaces a random stretch of up to 8 bytes of `text` with one of the corpus fragments, so
+ *         that edits split tokens, join them and open or close comments and literals.
+ * @return The edited text and the edit that was made.
+ */
+std::pair<std::string, cc::text_edit> edit(std::string_view text, std::mt19937 &random)
+{
+    const auto offset = random() % (text.size() + 1);
+    const auto removed = std::min<std::size_t>(random() % 9, text.size() - offset);
+    const auto inserted = cc::test::fragments[random() % std::size(cc::test::fragments)];
+
+    auto edited = std::string(text.substr(0, offset));
+    edited += inserted;
+    edited += text.substr(offset + removed);
+
+    return {
+        std::move(edited),
+        {
+            .offset          = static_cast<std::uint32_t>(offset),
+            .removed_length  = static_cast<std::uint32_t>(removed),
+            .inserted_length = static_cast<std::uint32_t>(inserted.size()),
+        },
+    };
+}
+
+} // namespace
+
+// Checks that after every edit, the incrementally updated tokens are exactly what lexing the whole
+// buffer again produces, and that positions are resolved against the edited buffer.
+int main(int argc, char **argv)
+{
+    try
+    {
+        auto &manager = cc::source_manager::instance();
+        const auto corpus = cc::test::load_corpus(argc, argv);
+        auto random = std::mt19937(cc::test::seed);
+
+        for (std::size_t i = 0; i < corpus.size(); i++)
+        {
+            // The previous buffer has to stay alive until the lexer has moved over to the next one
+            std::deque<std::string> buffers = {corpus[i]};
+            auto incremental = cc::incremental_lexer(manager.add_file("<corpus " + std::to_string(i) + ">", buffers.back()));
+
+            for (std::size_t j = 0; j < edits_per_source; j++)
+            {
+                auto [text, change] = edit(buffers.back(), random);
+                incremental.apply_edit(buffers.emplace_back(std::move(text)), change);
+                buffers.pop_front();
+
+                auto lexer = cc::lexer(incremental.file());
+                const auto &end = incremental.tokens().back().location;
+                const auto reference_file = manager.add_file("<reference>", buffers.back());
+                const auto is_same_position = manager.position(end) == manager.position({end.offset, reference_file});
+                manager.remove_file(reference_file);
+
+                if (!cc::test::same_tokens(lexer.lex_contents(), incremental.tokens(), "incremental lexer") || !is_same_position)
+                {
+                    std::cerr << "on source " << i << " after edit " << j << " at offset " << change.offset << '\n';
+                    return EXIT_FAILURE;
+                }
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,38 @@
+#include "lexer.h"
+#include "source_manager.h"
+#include "test_corpus.h"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+
+// Checks that the table-driven lexer produces exactly the tokens of the hand-written reference
+// lexer, on the corpus files named on the command line and on generated sources.
+int main(int argc, char **argv)
+{
+    try
+    {
+        const auto corpus = cc::test::load_corpus(argc, argv);
+
+        for (std::size_t i = 0; i < corpus.size(); i++)
+        {
+            const auto file = cc::source_manager::instance().add_file("<corpus " + std::to_string(i) + ">", corpus[i]);
+
+            auto reference = cc::lexer(file, cc::lexer_engine::hand_written);
+            auto table_driven = cc::lexer(file, cc::lexer_engine::table_driven);
+
+            if (!cc::test::same_tokens(reference.lex_contents(), table_driven.lex_contents(), "table-driven lexer"))
+            {
+                std::cerr << "on source " << i << '\n';
+                return EXIT_FAILURE;
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,51 @@
+#include "lexer.h"
+#include "parallel_lexer.h"
+#include "source_manager.h"
+#include "test_corpus.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+namespace {
+
+constexpr std::size_t thread_counts[] = {2, 3, 7, 16, 64};
+
+} // namespace
+
+// Checks that parallel lexing produces exactly the tokens of the serial lexer. Chunks of a single
+// byte are allowed, so that even a small source is split in many places.
+int main(int argc, char **argv)
+{
+    try
+    {
+        const auto corpus = cc::test::load_corpus(argc, argv);
+
+        for (std::size_t i = 0; i < corpus.size(); i++)
+        {
+            const auto file = cc::source_manager::instance().add_file("<corpus " + std::to_string(i) + ">", corpus[i]);
+
+            auto serial = cc::lexer(file);
+            const auto reference = serial.lex_contents();
+
+            for (const auto thread_count : thread_counts)
+            {
+                auto parallel = cc::parallel_lexer(file, thread_count, cc::lexer_engine::table_driven, 1);
+                if (!cc::test::same_tokens(reference, parallel.lex_buffer(), "parallel lexer"))
+                {
+                    std::cerr << "on source " << i << " with " << thread_count << " threads\n";
+                    return EXIT_FAILURE;
+                }
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
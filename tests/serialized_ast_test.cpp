@@ -0,0 +1,152 @@
+#include "flat_ast.h"
+#include "lexer.h"
+#include "parser.h"
+#include "serialized_ast.h"
+#include "source_manager.h"
+#include "test_corpus.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+bool same_token(cc::token_ref a, cc::token_ref b)
+{
+    return a.type() == b.type() && a.text() == b.text() && a.value() == b.value() && a.position() == b.position();
+}
+
+/**
+ * @brief  Serializes the tree of a source and reads it back.
+ * @return `true` if the tree read back has the same nodes as the original, and every node has a
+ *         token with the same type, text, value and position. `false` otherwise.
+ */
+bool round_trips(cc::file_id file)
+{
+    auto lexer = cc::lexer(file);
+    const auto tokens = lexer.lex_buffer();
+    const auto original = cc::flat_parser(tokens).parse_contents();
+
+    const auto bytes = cc::serialize(original);
+    std::string source;
+    const auto read_back = cc::to_flat_ast(cc::serialized_ast(bytes), source);
+
+    if (read_back.size() != original.size())
+    {
+        return false;
+    }
+
+    for (cc::node_index i = 0; i < original.size(); i++)
+    {
+        const auto &x = original[i];
+        const auto &y = read_back[i];
+        if (x.kind != y.kind || x.flags != y.flags || x.first_child != y.first_child || x.next_sibling != y.next_sibling ||
+            !same_token(original.token(i), read_back.token(i)))
+        {
+            return false;
+        }
+
+        const auto is_declaration = x.kind == cc::syntax_type::variable_declaration ||
+                                    x.kind == cc::syntax_type::function_declaration;
+        if (is_declaration && !same_token(original.tokens()[x.token + 1], read_back.tokens()[y.token + 1]))
+        {
+            return false;
+        }
+    }
+
+    return cc::to_syntax_tree(read_back)->tree_representation() == cc::to_syntax_tree(original)->tree_representation();
+}
+
+/**
+ * @brief  Serializes `text`, moves the first stored token that is past line 1 to `line` and
+ *         `column`, and reads the result back.
+ * @return `true` if the result is rejected with an `std::runtime_error`. `false` if it is read.
+ */
+bool rejects_position(std::string_view text, std::uint32_t line, std::uint32_t column)
+{
+    auto lexer = cc::lexer(text);
+    const auto tokens = lexer.lex_buffer();
+    auto bytes = cc::serialize(cc::flat_parser(tokens).parse_contents());
+
+    cc::serialized_ast_header header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    for (std::size_t i = 0; i < header.token_count; i++)
+    {
+        auto *record = bytes.data() + header.tokens_offset + i * sizeof(cc::serialized_token);
+
+        cc::serialized_token token;
+        std::memcpy(&token, record, sizeof(token));
+        if (token.line > 1)
+        {
+            token.line = line;
+            token.column = column;
+            std::memcpy(record, &token, sizeof(token));
+            break;
+        }
+    }
+
+    try
+    {
+        std::string source;
+        cc::to_flat_ast(cc::serialized_ast(bytes), source);
+    }
+    catch (const std::runtime_error &)
+    {
+        return true;
+    }
+
+    return false;
+}
+
+} // namespace
+
+// Checks that the tree of every corpus source reads back from its serialized form as it was written,
+// and that corrupt positions are rejected as corrupt instead of failing in some other way.
+int main(int argc, char **argv)
+{
+    try
+    {
+        const auto corpus = cc::test::load_corpus(argc, argv);
+
+        for (std::size_t i = 0; i < corpus.size(); i++)
+        {
+            const auto file = cc::scoped_file("<corpus " + std::to_string(i) + ">", corpus[i]);
+            if (!round_trips(file.id()))
+            {
+                std::cerr << "The tree of source " << i << " does not read back as it was written\n";
+                return EXIT_FAILURE;
+            }
+        }
+
+        constexpr std::string_view program = "int main()\n{\n    return 1;\n}\n";
+        constexpr std::uint32_t far = 0xFFFFFFFF;
+        const struct
+        {
+            std::uint32_t line;
+            std::uint32_t column;
+        } corrupt_positions[] = {{2, 0}, {0, 1}, {0, 0}, {far, 1}, {2, far}, {far, far}};
+
+        for (const auto &[line, column] : corrupt_positions)
+        {
+            if (!rejects_position(program, line, column))
+            {
+                std::cerr << "A token at (" << line << ',' << column << ") is not rejected\n";
+                return EXIT_FAILURE;
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,82 @@
+#include "lexer.h"
+#include "source_manager.h"
+#include "token_buffer.h"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+
+namespace {
+
+/**
+ * @brief  Whether resolving `location` throws `std::out_of_range`.
+ */
+bool is_stale(cc::source_location location)
+{
+    try
+    {
+        cc::source_manager::instance().position(location);
+    }
+    catch (const std::out_of_range &)
+    {
+        return true;
+    }
+
+    return false;
+}
+
+} // namespace
+
+// Checks that replaced files resolve against their new text, and that locations in removed files, or
+// past the end of a file, are refused rather than resolved against whatever the id now refers to.
+int main()
+{
+    try
+    {
+        auto &manager = cc::source_manager::instance();
+
+        const auto file = cc::scoped_file("<replaced>", "a\nb\n");
+        if (manager.position({3, file.id()}) != cc::source_position{2, 2})
+        {
+            std::cerr << "A position is resolved wrongly\n";
+            return EXIT_FAILURE;
+        }
+
+        manager.replace_file(file.id(), "a\n\n\nb\n");
+        if (manager.position({3, file.id()}) != cc::source_position{3, 1})
+        {
+            std::cerr << "A replaced file is resolved against its old line table\n";
+            return EXIT_FAILURE;
+        }
+
+        if (!is_stale({7, file.id()}))
+        {
+            std::cerr << "An offset past the end of a file is resolved\n";
+            return EXIT_FAILURE;
+        }
+
+        // The tokens outlive the lexer, and with it the file it registered
+        std::optional<cc::token_buffer> tokens;
+        {
+            auto lexer = cc::lexer(std::string_view("int x;\nint y;\n"));
+            tokens = lexer.lex_buffer();
+        }
+        const auto later = cc::scoped_file("<later>", "int z;\n");
+
+        if (later.id() == tokens->file() || !is_stale((*tokens)[3].location()))
+        {
+            std::cerr << "A location in a removed file is resolved\n";
+            return EXIT_FAILURE;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,99 @@
+#ifndef C_COMPILER_TEST_CORPUS_H
+#define C_COMPILER_TEST_CORPUS_H
+
+#include "file_buffer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <string_view>
+
+namespace cc::test {
+
+/**
+ * @brief The seed of every random choice a test makes, so that a failure can be reproduced.
+ */
+inline constexpr std::uint32_t seed = 42;
+
+/**
+ * @brief How many sources are generated on top of the corpus files, and how many fragments each is
+ *        made of.
+ */
+inline constexpr std::size_t generated_source_count = 200;
+inline constexpr std::size_t fragments_per_source = 400;
+
+/**
+ * @brief Pieces that generated sources are glued together from. Besides ordinary code, they contain
+ *        everything that can make a token run on into the next one: comment delimiters, quotes,
+ *        line continuations and partial numbers.
+ */
+inline constexpr std::string_view fragments[] = {
+    "int", "return", "while", "x", "_tmp", "value1", " ", "  ", "\t", "\n", "\r\n", "\\\n", "\\",
+    "/", "*", "/*", "*/", "//", "\"", "\"abc\"", "\"a\\\"b\"", "\\n", "'", "'c'", "0", "7", "0755", "42",
+    "1.5", ".5", "e", "e+", "E-", "3f", "1e10", "0x1F", "(", ")", "{", "}", "[", "]", ";", ",", "+", "-",
+    "=", "+=", "++", "<<", ">>", "&&", "||", "!=", "==", "!", "~", "^", "%", "@", "$", "#",
+};
+
+/**
+ * @brief  Generates a source that is a random sequence of `fragments`.
+ */
+inline std::string generate_source(std::mt19937 &random)
+{
+    std::string source;
+
+    for (std::size_t i = 0; i < fragments_per_source; i++)
+    {
+        source += fragments[random() % std::size(fragments)];
+    }
+
+    return source;
+}
+
+/**
+ * @brief  Loads the corpus files named on the command line, followed by sources generated from
+ *         `seed`. A deque never relocates its elements, so views of the sources stay valid.
+ * @throw  std::system_error If a corpus file cannot be read.
+ */
+inline std::deque<std::string> load_corpus(int argc, char **argv)
+{
+    std::deque<std::string> corpus;
+
+    for (int i = 1; i < argc; i++)
+    {
+        corpus.emplace_back(cc::file_buffer(argv[i]).contents());
+    }
+
+    auto random = std::mt19937(seed);
+    for (std::size_t i = 0; i < generated_source_count; i++)
+    {
+        corpus.push_back(generate_source(random));
+    }
+
+    return corpus;
+}
+
+/**
+ * @brief  Compares two token streams and reports where they first differ.
+ * @return `true` if both streams are identical. `false` otherwise.
+ */
+template<typename Expected, typename Actual>
+bool same_tokens(const Expected &expected, const Actual &actual, std::string_view what)
+{
+    const auto [expected_token, actual_token] = std::mismatch(expected.begin(), expected.end(), actual.begin(), actual.end());
+    if (expected_token != expected.end() || actual_token != actual.end())
+    {
+        std::cerr << what << " differs at token " << std::distance(expected.begin(), expected_token) << '\n';
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace cc::test
+
+#endif